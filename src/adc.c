@@ -8,7 +8,16 @@
  * calibration routine to map ADC values to corresponding motor
  * speeds (positive and negative). An interrupt-driven approach
  * is used to read from ADC channels 4 and 5 for the left and
- * right motors, respectively.
+ * right motors, respectively. Each operating mode installs its own
+ * handler in the SRAM vector table (vecteurs.c): calibration only
+ * accumulates, run also confirms the analog watchdog events, and
+ * low-power only clears the flags.
+ *
+ * The samples of a tick are summed in one of two banks. Each tick the
+ * control task switches the bank that the interrupt fills and reads the
+ * other one. On the single Cortex-M0 core the interrupt runs to completion
+ * before the main loop resumes, so the read bank is never being written
+ * and no interrupt needs to be masked.
  *
  * @author      Thomas Giguere Sturrock
  * @date        Jun 2022
@@ -18,6 +27,7 @@
 #include "adc.h"
 #include "main.h"
 #include "pwm.h"
+#include "vecteurs.h"
 /* Defines -------------------------------------------------------------------*/
 #define GAUCHE 0
 #define DROITE 1
@@ -29,15 +39,21 @@
 /* Private variables ---------------------------------------------------------*/
 
 static uint8_t channel = GAUCHE;		//La variable utilise pour garder en memoire le canal a echantillone
-static int32_t echantillon_droite=0;	//La somme des echantillons du moteur droite
-static int32_t echantillon_gauche=0;	//La somme des echantillons du moteur gauche
-static uint16_t compteur_gauche=0;		//La nombre d'echantillons du moteur droite
-static uint16_t compteur_droite=0;		//La nombre d'echantillons du moteur gauche
-
-int32_t echantillon_droite_temp;
-uint16_t compteur_droite_temp;
-int32_t echantillon_gauche_temp;
-uint16_t compteur_gauche_temp;
+static banque_adc_t banques[2];			//Sommes des echantillons, une banque remplie par l'interruption
+static volatile uint8_t banque_active=0;	//Banque remplie par l'interruption
+
+static uint16_t seuil_surcourant=0xFFF;		//Seuil haut du watchdog analogique
+static uint8_t blocage_arme[2]={0,0};			//Detection de blocage active pour chaque moteur
+static uint8_t compteur_arme[2]={0,0};			//Nb de ticks a duty eleve pour chaque moteur
+static uint8_t depassement[2]={0,0};			//Nb d'echantillons consecutifs au-dessus du seuil de surcourant
+static volatile uint8_t echantillons_tournant[2]={0,0};	//Compte (modulo 256) des echantillons au-dessus du seuil bas
+static uint8_t tournant_vus[2]={0,0};			//Valeur de echantillons_tournant au tick precedent
+static uint8_t ticks_blocage[2]={0,0};			//Nb de ticks sans echantillon au-dessus du seuil bas
+static int8_t sens_arme[2]={0,0};				//Signe du duty pendant l'armement
+static volatile uint8_t defaut_moteur=0;		//Defaut detecte par le watchdog analogique
+static int16_t zone_morte_gauche=0;				//Duty minimal pour que le moteur gauche tourne (1/10000)
+static int16_t zone_morte_droite=0;				//Duty minimal pour que le moteur droit tourne (1/10000)
+static volatile uint16_t cycles_isr_max=0;			//Plus longue execution de ADC1_COMP_IRQHandler (cycles)
 
 
 int32_t vg_max_p;	 	//La voltage max positif du moteur gauche
@@ -60,6 +76,13 @@ int32_t abcisse_p_moteur_droite;
 int32_t abcisse_n_moteur_gauche;
 int32_t abcisse_n_moteur_droite;
 
+/* Private function prototypes -----------------------------------------------*/
+static void delay_in_5ms(uint16_t nb_5ms);
+static void echanger_banque(banque_adc_t *lue);
+static inline void accumuler(uint8_t canal, uint16_t donnee) __attribute__((always_inline));
+static RAMFUNC void adc_isr_calibration(void);
+static RAMFUNC void adc_isr_veille(void);
+
 /* Public functions  ---------------------------------------------------------*/
 /**
  * @brief  Fonction qui configure le peripherique d'ADC
@@ -67,22 +90,22 @@ int32_t abcisse_n_moteur_droite;
  * @retval None
  */
 void config_adc(void){
-	//Les canaux 4 et 5 sont utilise par l'adc, mais les canaux 6 et 7 sont utiliser pour obtenir le sens de rotation des roues
-	GPIOA->MODER |= GPIO_MODER_MODER4;	//Configure le canal 4 comme une entree analogue
-	GPIOA->PUPDR &= ~(GPIO_PUPDR_PUPDR4); 		//Entree 4 est analogue, aucune pull-up/down
+	//Les mesures (PA4 et PA5) sont lues par l'adc, les broches de sens (PA6 et PA7) donnent le sens de rotation des roues
+	BROCHE_MODE(MESURE_GAUCHE, GPIO_ANALOG);	//Configure la mesure gauche comme une entree analogue
+	GPIO_PUPD_CONFIG(BROCHE_GPIO(MESURE_GAUCHE), MESURE_GAUCHE_PIN, NO_PULL); 	//Entree analogue, aucune pull-up/down
 
-	GPIOA->MODER |= GPIO_MODER_MODER5;	//Configure le canal 5 comme une entree analogue
-	GPIOA->PUPDR &= ~(GPIO_PUPDR_PUPDR5); 		//Entree 5 est analogue, aucune pull-up/down
+	BROCHE_MODE(MESURE_DROITE, GPIO_ANALOG);	//Configure la mesure droite comme une entree analogue
+	GPIO_PUPD_CONFIG(BROCHE_GPIO(MESURE_DROITE), MESURE_DROITE_PIN, NO_PULL); 	//Entree analogue, aucune pull-up/down
 
-	GPIOA->MODER &= ~(GPIO_MODER_MODER6); 	//Configure le canal 6 comme une entree
-	GPIOA->PUPDR |= (GPIO_PUPDR_PUPDR6_1);		//Entree 6, aucune pull-up/down
+	BROCHE_MODE(SENS_GAUCHE, GPIO_INPUT); 	//Configure le sens gauche comme une entree
+	GPIO_PUPD_CONFIG(BROCHE_GPIO(SENS_GAUCHE), SENS_GAUCHE_PIN, PULL_DOWN);	//Pull-down
 
-	GPIOA->MODER &= ~(GPIO_MODER_MODER7);	//Configure le canal 7 comme une entree
-	GPIOA->PUPDR |= (GPIO_PUPDR_PUPDR7_1);		//Entree 7, aucune pull-up/down
+	BROCHE_MODE(SENS_DROITE, GPIO_INPUT);	//Configure le sens droit comme une entree
+	GPIO_PUPD_CONFIG(BROCHE_GPIO(SENS_DROITE), SENS_DROITE_PIN, PULL_DOWN);	//Pull-down
 
-	GPIOA->MODER |= (GPIO_MODER_MODER8_0); 	//Configure le canal 8 comme une sortie
-	GPIO_OTYPE_CONFIG(GPIOA,8,1);				//Open drain
-	GPIOA->PUPDR |= (GPIO_PUPDR_PUPDR8_0);		//PULL-UP
+	BROCHE_MODE(CALIBRATION, GPIO_OUTPUT); 	//Configure la broche de calibration comme une sortie
+	GPIO_OTYPE_CONFIG(BROCHE_GPIO(CALIBRATION), CALIBRATION_PIN, GPIO_OPEN_DRAIN);
+	GPIO_PUPD_CONFIG(BROCHE_GPIO(CALIBRATION), CALIBRATION_PIN, PULL_UP);
 
 	//Setup du signal d'horloge
 	RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
@@ -90,7 +113,7 @@ void config_adc(void){
 	RCC->APB2RSTR &= ~RCC_APB2RSTR_ADCRST;
 	// Change le hpre et le ppre au besoin si ca ne fonctionne pas
 	ADC1->CFGR2 &= ~ADC_CFGR2_CKMODE;
-	ADC1->CFGR2 |= ADC_CFGR2_CKMODE_1; 		//On divise la clock de 48MHz par 4 -> 12 MHz
+	ADC1->CFGR2 |= ADC_CFGR2_CKMODE_1; 		//On divise PCLK par 4 -> 12 MHz a 48MHz, 2 MHz en frequence reduite
 
 	ADC1->CFGR1 |= ADC_CFGR1_WAIT; 			//Mode attente active
 	ADC1->CFGR1 |= ADC_CFGR1_CONT; 			//Mode lecture continue active
@@ -102,12 +125,13 @@ void config_adc(void){
 	ADC1->IER |= ADC_IER_EOCIE;
 	//ADC1->IER |= ADC_IER_EOSEQIE;
 
-	NVIC->ISER[0] = (((uint32_t) 1) << (ADC1_COMP_IRQn & 0x1F));
-	NVIC->IP[(uint32_t)(ADC1_COMP_IRQn>>2)] = ADC_PRIORITY-(1<<(((ADC1_COMP_IRQn & 0x03) << 3)*8));
+	adc_mode(ADC_MODE_CALIBRATION);		//Le watchdog analogique est configure apres la calibration
+	NVIC_SetPriority(ADC1_COMP_IRQn, PRIORITE_ADC);
+	NVIC_EnableIRQ(ADC1_COMP_IRQn);
 
 	ADC1->SMPR |= (ADC_SMPR1_SMPR_1|ADC_SMPR1_SMPR_0); //239.5cycles
 
-	ADC1->CHSELR |= (ADC_CHSELR_CHSEL4|ADC_CHSELR_CHSEL5); //Permet a l'ADC d'echantillonner le canal 4 et 5
+	ADC1->CHSELR |= (BROCHE_MASQUE(MESURE_GAUCHE)|BROCHE_MASQUE(MESURE_DROITE)); //Permet a l'ADC d'echantillonner les deux mesures (canal = broche de PA)
 
 	ADC1->CR |= ADC_CR_ADCAL;//Part la calibration
 
@@ -120,35 +144,60 @@ void config_adc(void){
 	ADC1->CR |= ADC_CR_ADSTART;
 }
 
-void ADC1_COMP_IRQHandler(void){
-	//Conversion du moteur gauche
-	if(channel==GAUCHE){
-		channel=DROITE;
-		//Valeur negative
-		if((GPIOA->IDR & ((uint16_t)GPIO_IDR_6))== ((uint16_t)GPIO_IDR_6)){
-			echantillon_gauche -= (int32_t)ADC1->DR;
-		}
-		//Valeur positive
-		else{
-			echantillon_gauche += (int32_t)ADC1->DR;
+/**
+ * @brief  interuption de fin de conversion de l'ADC en marche (la plus frequente, s'execute
+ *         depuis la RAM). Confirme les depassements du watchdog analogique
+ * @param  None
+ * @retval None
+ */
+RAMFUNC void ADC1_COMP_IRQHandler(void){
+	uint32_t debut = SysTick->VAL;
+	uint32_t cycles;
+	uint8_t canal = channel;
+	uint16_t donnee = (uint16_t)ADC1->DR; //La lecture de DR efface EOC
+
+	/*
+	 * Le watchdog analogique compare chaque conversion aux seuils en materiel,
+	 * on n'a qu'a confirmer le depassement sur quelques echantillons consecutifs
+	 */
+	if((ADC1->ISR & ADC_ISR_AWD) && donnee > seuil_surcourant){
+		ADC1->ISR = ADC_ISR_AWD;
+		echantillons_tournant[canal]++;
+		if(++depassement[canal] >= ADC_AWD_CONFIRMATION_SURCOURANT){
+			arret_moteur();
+			defaut_moteur |= DEFAUT_SURCOURANT;
 		}
-		compteur_gauche+=1;
 	}
-	//Conversion du moteur droit
-	else if(channel==DROITE){
-		channel=GAUCHE;
-		//Valeur negative
-		if((GPIOA->IDR & ((uint16_t)GPIO_IDR_7)) == ((uint16_t)GPIO_IDR_7)){
-			echantillon_droite -= (int32_t)ADC1->DR;
-		}
-		//Valeur positive
-		else{
-			echantillon_droite += (int32_t)ADC1->DR;
-		}
-		compteur_droite+=1;
+	else if(ADC1->ISR & ADC_ISR_AWD){
+		//Sous le seuil bas : le blocage est confirme sur plusieurs ticks (adc_watchdog_armer)
+		ADC1->ISR = ADC_ISR_AWD;
+		depassement[canal]=0;
 	}
+	else{
+		echantillons_tournant[canal]++;
+		depassement[canal]=0;
+	}
+
+	accumuler(canal, donnee);
+
+	cycles = systick_cycles_depuis(debut);
+	if(cycles > cycles_isr_max)
+		cycles_isr_max = (cycles > 0xFFFF) ? 0xFFFF : (uint16_t)cycles;
 }
 
+/**
+ * @brief  Fonction qui installe la routine d'interruption de l'ADC du mode de fonctionnement
+ * @param  uint8_t mode : ADC_MODE_CALIBRATION, ADC_MODE_MARCHE ou ADC_MODE_VEILLE
+ * @retval None
+ */
+void adc_mode(uint8_t mode){
+	if(mode == ADC_MODE_CALIBRATION)
+		vecteurs_installer(ADC1_COMP_IRQn, adc_isr_calibration);
+	else if(mode == ADC_MODE_VEILLE)
+		vecteurs_installer(ADC1_COMP_IRQn, adc_isr_veille);
+	else
+		vecteurs_installer(ADC1_COMP_IRQn, ADC1_COMP_IRQHandler);
+}
 
 /**
  * @brief  Fonction qui defini la valeur moyenne ressu par l'adc depuis
@@ -157,78 +206,42 @@ void ADC1_COMP_IRQHandler(void){
  * @retval None
  */
 void vitesse_moyenne_mesure(void){
-	//Copie les donnees d'echantillons
-	__set_PRIMASK(1);
-
-	echantillon_droite_temp=echantillon_droite;
-	compteur_droite_temp=compteur_droite;
-	echantillon_gauche_temp=echantillon_gauche;
-	compteur_gauche_temp=compteur_gauche;
+	banque_adc_t lue;
+	int32_t v_gauche, v_droite;
 
-	//Purge la memoire pour collecter d'autres donnes
-	echantillon_droite=0;
-	compteur_droite=0;
-	echantillon_gauche=0;
-	compteur_gauche=0;
-	__set_PRIMASK(0);
+	//Change de banque : les echantillons suivants vont dans l'autre
+	echanger_banque(&lue);
 
 	if(adc_5ms){
-		__set_PRIMASK(1);
 		adc_5ms=0;
 
-		if(compteur_droite_temp>0){
-			controlData.v_moyenne_droite=echantillon_droite_temp/(int32_t)compteur_droite_temp;
-			echantillon_droite_temp=0;
-			compteur_droite_temp=0;
-		}
-		if(compteur_gauche>0){
-			controlData.v_moyenne_gauche=echantillon_gauche_temp/(int32_t)compteur_gauche_temp;
-			echantillon_gauche_temp=0;
-			compteur_gauche_temp=0;
-		}
-		//On reactive les interruption et la conversion
-		__set_PRIMASK(0);
+		//Une moyenne sans echantillon garde la mesure precedente
+		pullMesure(&controlData,&v_gauche,&v_droite);
+		if(lue.compteur_droite>0)
+			v_droite=lue.somme_droite/(int32_t)lue.compteur_droite;
+		if(lue.compteur_gauche>0)
+			v_gauche=lue.somme_gauche/(int32_t)lue.compteur_gauche;
+		updateMesure(&controlData,v_gauche,v_droite);
 	}
 }
 
 void moyenne(int32_t* v_droite, int32_t* v_gauche){
+	banque_adc_t lue;
+
 	//Purge la memoire et on demarre un autre echantillonage
 	while(adc_5ms==0){}
-	__set_PRIMASK(1);
-	echantillon_droite=0;
-	compteur_droite=0;
-	echantillon_gauche=0;
-	compteur_gauche=0;
+	echanger_banque(&lue);
 	adc_5ms=0;
-	__set_PRIMASK(0);
 	while(adc_5ms==0){}
 
 	//Copie les donnees d'echantillons
-	__set_PRIMASK(1);
-	echantillon_droite_temp=echantillon_droite;
-	compteur_droite_temp=compteur_droite;
-	echantillon_gauche_temp=echantillon_gauche;
-	compteur_gauche_temp=compteur_gauche;
-	__set_PRIMASK(0);
-
-
-	if(adc_5ms){
-
-		adc_5ms=0;
-
-		if(compteur_droite_temp>0){
-			*v_droite=echantillon_droite_temp/(int32_t)compteur_droite_temp;
-			echantillon_droite_temp=0;
-			compteur_droite_temp=0;
-
-		}
-		if(compteur_gauche_temp>0){
-			*v_gauche=echantillon_gauche_temp/(int32_t)compteur_gauche_temp;
-			echantillon_gauche_temp=0;
-			compteur_gauche_temp=0;
-		}
+	echanger_banque(&lue);
+	adc_5ms=0;
 
-	}
+	if(lue.compteur_droite>0)
+		*v_droite=lue.somme_droite/(int32_t)lue.compteur_droite;
+	if(lue.compteur_gauche>0)
+		*v_gauche=lue.somme_gauche/(int32_t)lue.compteur_gauche;
 }
 
 /**
@@ -237,9 +250,16 @@ void moyenne(int32_t* v_droite, int32_t* v_gauche){
  * @retval None
  */
 void delay_in_sec(uint16_t time_in_sec){
-	uint16_t counter;
-	counter=time_in_sec*1000/5;
-	for(uint16_t delay=0;delay<counter;delay+=1){
+	delay_in_5ms(time_in_sec*1000/CONTROLE_PERIODE_MS);
+}
+
+/**
+ * @brief  Fonction qui cree un delais en nombre de ticks de controle
+ * @param uint16_t nb_5ms : longueur du delais voulu en nombre de ticks
+ * @retval None
+ */
+static void delay_in_5ms(uint16_t nb_5ms){
+	for(uint16_t delay=0;delay<nb_5ms;delay+=1){
 		while(adc_5ms==0){}
 		adc_5ms=0;
 	}
@@ -251,7 +271,7 @@ void delay_in_sec(uint16_t time_in_sec){
  * @retval None
  */
 void moteur_calibration(void){
-	GPIO_SET(GPIOA, 8);
+	BROCHE_SET(CALIBRATION);
 	delay_in_sec(1);
 
 	//Calcul de la valeur max positive
@@ -276,9 +296,11 @@ void moteur_calibration(void){
 	delay_in_sec(CONSTANTE_MOTEUR);
 	moyenne(&vd_min_n,&vg_min_n);
 
-	GPIO_RESET(GPIOA, 8);
+	BROCHE_RESET(CALIBRATION);
 
 	vitesse_mapping_init();
+	mesure_zone_morte();
+	config_adc_watchdog();
 }
 
 /**
@@ -302,31 +324,337 @@ void vitesse_mapping_init(void){
  * @retval None
  */
 void vitesse_mapping(float* v_moyenne_gauche,float* v_moyenne_droite){
+	int32_t v_gauche, v_droite;
 
-	if(controlData.v_moyenne_gauche >= vg_min_p){
-		*v_moyenne_gauche = ((float)(controlData.v_moyenne_gauche-vg_min_p)/pente_p_moteur_gauche);
+	pullMesure(&controlData,&v_gauche,&v_droite);
+
+	if(v_gauche >= vg_min_p){
+		*v_moyenne_gauche = ((float)(v_gauche-vg_min_p)/pente_p_moteur_gauche);
 	}
-	else if ((controlData.v_moyenne_gauche < vg_min_p) && (controlData.v_moyenne_gauche > vg_min_n)){
+	else if ((v_gauche < vg_min_p) && (v_gauche > vg_min_n)){
 		*v_moyenne_gauche = 0;
 	}
 	else{
-		*v_moyenne_gauche =((float)(controlData.v_moyenne_gauche-vg_min_n)/pente_n_moteur_gauche);
+		*v_moyenne_gauche =((float)(v_gauche-vg_min_n)/pente_n_moteur_gauche);
 	}
 
 	//cote droite
-	if(controlData.v_moyenne_droite >= vd_min_p){
-		*v_moyenne_droite =((float)(controlData.v_moyenne_droite-vd_min_p)/pente_p_moteur_droite);
+	if(v_droite >= vd_min_p){
+		*v_moyenne_droite =((float)(v_droite-vd_min_p)/pente_p_moteur_droite);
 	}
-	else if ((controlData.v_moyenne_droite < vd_min_p) && (controlData.v_moyenne_droite > vd_min_n)){
+	else if ((v_droite < vd_min_p) && (v_droite > vd_min_n)){
 		*v_moyenne_droite = 0;
 	}
 	else{
-		*v_moyenne_droite = ((float)(controlData.v_moyenne_droite-vd_min_n)/pente_n_moteur_droite);
+		*v_moyenne_droite = ((float)(v_droite-vd_min_n)/pente_n_moteur_droite);
+	}
+}
+
+/**
+ * @brief  Fonction qui mesure le duty minimal pour que chaque moteur tourne
+ * @param  None
+ * @retval None
+ */
+void mesure_zone_morte(void){
+	int32_t v_droite;
+	int32_t v_gauche;
+	uint8_t trouve_gauche=0;
+	uint8_t trouve_droite=0;
+
+	zone_morte_gauche = (int16_t)(ZONE_MORTE_MAX*10000);
+	zone_morte_droite = (int16_t)(ZONE_MORTE_MAX*10000);
+
+	//On augmente le duty jusqu'a ce que la mesure se detache de celle a l'arret
+	for(float duty=ZONE_MORTE_PAS; (duty<=ZONE_MORTE_MAX) && !(trouve_gauche && trouve_droite); duty+=ZONE_MORTE_PAS){
+		update_moteur(trouve_gauche ? ARRET : duty, trouve_droite ? ARRET : duty, 0);
+		delay_in_5ms(ZONE_MORTE_DELAI);
+		moyenne(&v_droite,&v_gauche);
+
+		if(!trouve_gauche && (v_gauche-vg_min_p) > pente_p_moteur_gauche/ZONE_MORTE_FRACTION){
+			zone_morte_gauche = (int16_t)(duty*10000);
+			trouve_gauche = 1;
+		}
+		if(!trouve_droite && (v_droite-vd_min_p) > pente_p_moteur_droite/ZONE_MORTE_FRACTION){
+			zone_morte_droite = (int16_t)(duty*10000);
+			trouve_droite = 1;
+		}
+	}
+	update_moteur(ARRET,ARRET,0);
+}
+
+/**
+ * @brief  accesseur de la zone morte des moteurs mesuree a la calibration
+ * @param  int16_t *zm_gauche : duty minimal du moteur gauche (1/10000)
+ *         int16_t *zm_droite : duty minimal du moteur droit (1/10000)
+ * @retval None
+ */
+void pull_zone_morte(int16_t *zm_gauche, int16_t *zm_droite){
+	*zm_gauche = zone_morte_gauche;
+	*zm_droite = zone_morte_droite;
+}
+
+/**
+ * @brief  Fonction qui configure le watchdog analogique de l'ADC sur les canaux
+ *         des moteurs avec des seuils tires de la calibration
+ * @param  None
+ * @retval None
+ */
+void config_adc_watchdog(void){
+	uint32_t maximum;
+	uint32_t arret;
+	uint32_t pente;
+	uint32_t seuil_blocage;
+
+	//Plus grande amplitude mesuree a pleine vitesse
+	maximum = (uint32_t)abs(vg_max_p);
+	maximum = ((uint32_t)abs(vg_max_n) > maximum) ? (uint32_t)abs(vg_max_n) : maximum;
+	maximum = ((uint32_t)abs(vd_max_p) > maximum) ? (uint32_t)abs(vd_max_p) : maximum;
+	maximum = ((uint32_t)abs(vd_max_n) > maximum) ? (uint32_t)abs(vd_max_n) : maximum;
+
+	//Plus grande amplitude mesuree a l'arret
+	arret = (uint32_t)abs(vg_min_p);
+	arret = ((uint32_t)abs(vg_min_n) > arret) ? (uint32_t)abs(vg_min_n) : arret;
+	arret = ((uint32_t)abs(vd_min_p) > arret) ? (uint32_t)abs(vd_min_p) : arret;
+	arret = ((uint32_t)abs(vd_min_n) > arret) ? (uint32_t)abs(vd_min_n) : arret;
+
+	//Plus petite pente des quatre sens de rotation
+	pente = (uint32_t)abs(pente_p_moteur_gauche);
+	pente = ((uint32_t)abs(pente_p_moteur_droite) < pente) ? (uint32_t)abs(pente_p_moteur_droite) : pente;
+	pente = ((uint32_t)abs(pente_n_moteur_gauche) < pente) ? (uint32_t)abs(pente_n_moteur_gauche) : pente;
+	pente = ((uint32_t)abs(pente_n_moteur_droite) < pente) ? (uint32_t)abs(pente_n_moteur_droite) : pente;
+
+	maximum += maximum/ADC_AWD_MARGE_SURCOURANT;
+	seuil_surcourant = (maximum > 0xFFF) ? 0xFFF : (uint16_t)maximum;
+	seuil_blocage = arret + pente/ADC_AWD_FRACTION_BLOCAGE;
+	seuil_blocage = (seuil_blocage >= seuil_surcourant) ? 0 : seuil_blocage;
+
+	//Les seuils ne peuvent etre changes que lorsque l'ADC ne convertit pas
+	ADC1->CR |= ADC_CR_ADSTP;
+	while(ADC1->CR & ADC_CR_ADSTP);
+
+	ADC1->TR = ((uint32_t)seuil_surcourant << 16) | seuil_blocage;
+	ADC1->CFGR1 &= ~ADC_CFGR1_AWDSGL;	//Surveille tous les canaux de la sequence (les deux mesures)
+	ADC1->CFGR1 |= ADC_CFGR1_AWDEN;		//Active le watchdog analogique
+	ADC1->ISR = ADC_ISR_AWD;
+
+	channel = GAUCHE;					//La sequence recommence a la mesure gauche
+	adc_mode(ADC_MODE_MARCHE);
+	ADC1->CR |= ADC_CR_ADSTART;
+}
+
+/**
+ * @brief  accesseur de la plus longue execution de l'interruption de l'ADC
+ * @param  None
+ * @retval uint16_t : duree (cycles du coeur)
+ */
+uint16_t pull_adc_cycles_max(void){
+	return cycles_isr_max;
+}
+
+/**
+ * @brief  Fonction qui remet a 0 la plus longue execution de l'interruption de l'ADC
+ * @param  None
+ * @retval None
+ */
+void effacer_adc_cycles_max(void){
+	cycles_isr_max = 0;
+}
+
+/**
+ * @brief  Fonction qui arrete les conversions, desactive l'ADC et coupe son horloge (mise en veille)
+ * @param  None
+ * @retval None
+ */
+void adc_suspendre(void){
+	uint16_t essai;
+
+	ADC1->CR |= ADC_CR_ADSTP;
+	for(essai=0;essai<ADC_TIMEOUT && (ADC1->CR & ADC_CR_ADSTP);essai++);
+	ADC1->CR |= ADC_CR_ADDIS;
+	for(essai=0;essai<ADC_TIMEOUT && (ADC1->CR & ADC_CR_ADEN);essai++);
+	adc_mode(ADC_MODE_VEILLE);
+
+	RCC->APB2ENR &= ~RCC_APB2ENR_ADC1EN;
+}
+
+/**
+ * @brief  Fonction qui reactive l'horloge de l'ADC, le recalibre et relance les conversions
+ *         (les seuils du watchdog analogique sont conserves). Au timeout, le defaut DEFAUT_ADC
+ *         est leve et l'horloge de l'ADC est recoupee
+ * @param  None
+ * @retval uint8_t : 1 si l'ADC convertit de nouveau, 0 au timeout
+ */
+uint8_t adc_reprendre(void){
+	uint16_t essai;
+
+	RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
+
+	ADC1->CR |= ADC_CR_ADCAL;//La calibration se fait ADC desactive
+	for(essai=0;essai<ADC_TIMEOUT && (ADC1->CR & ADC_CR_ADCAL);essai++);
+	if(essai>=ADC_TIMEOUT){
+		defaut_moteur |= DEFAUT_ADC;	//ADEN ne doit pas etre ecrit pendant la calibration
+		RCC->APB2ENR &= ~RCC_APB2ENR_ADC1EN;
+		return 0;
 	}
+
+	ADC1->ISR = ADC_ISR_ADRDY;
+	ADC1->CR |= ADC_CR_ADEN;
+	for(essai=0;essai<ADC_TIMEOUT && !(ADC1->ISR & ADC_ISR_ADRDY);essai++);
+	if(essai>=ADC_TIMEOUT){
+		defaut_moteur |= DEFAUT_ADC;
+		ADC1->CR |= ADC_CR_ADDIS;		//l'ADC reste comme en veille
+		RCC->APB2ENR &= ~RCC_APB2ENR_ADC1EN;
+		return 0;
+	}
+
+	ADC1->ISR = ADC_ISR_AWD;
+	depassement[GAUCHE] = 0;
+	depassement[DROITE] = 0;
+	channel = GAUCHE;					//La sequence recommence a la mesure gauche
+	adc_mode(ADC_MODE_MARCHE);
+	ADC1->CR |= ADC_CR_ADSTART;
+	return 1;
 }
 
+/**
+ * @brief  Fonction qui arme la detection de blocage des moteurs qui sont commandes
+ *         avec un duty suffisant de meme signe depuis ADC_AWD_DELAI_BLOCAGE appels, et coupe
+ *         un moteur arme qui reste sous le seuil bas pendant ADC_AWD_CONFIRMATION_BLOCAGE
+ *         ticks (a appeler a chaque tick de controle)
+ * @param  float duty_g : duty applique au moteur gauche par l'etage de sortie
+ *         float duty_d : duty applique au moteur droit par l'etage de sortie
+ * @retval None
+ */
+void adc_watchdog_armer(float duty_g, float duty_d){
+	float duty[2];
+	duty[GAUCHE] = duty_g;
+	duty[DROITE] = duty_d;
+
+	for(uint8_t moteur=GAUCHE;moteur<=DROITE;moteur++){
+		int8_t sens = (duty[moteur] >= ADC_AWD_DUTY_BLOCAGE) ? AVANT : ((duty[moteur] <= -ADC_AWD_DUTY_BLOCAGE) ? ARRIERE : ARRET);
+		uint8_t tournant = echantillons_tournant[moteur];
+
+		//Une inversion passe par la vitesse nulle : l'armement recommence
+		if(sens == ARRET || sens != sens_arme[moteur]){
+			sens_arme[moteur] = sens;
+			compteur_arme[moteur] = 0;
+			blocage_arme[moteur] = 0;
+		}else if(!blocage_arme[moteur]){
+			if(compteur_arme[moteur] < ADC_AWD_DELAI_BLOCAGE){
+				compteur_arme[moteur]++;
+			}else{
+				blocage_arme[moteur] = 1;
+				ticks_blocage[moteur] = 0;
+			}
+		}else if(tournant != tournant_vus[moteur]){
+			ticks_blocage[moteur] = 0;	//au moins un echantillon au-dessus du seuil bas dans le tick
+		}else if(++ticks_blocage[moteur] >= ADC_AWD_CONFIRMATION_BLOCAGE){
+			arret_moteur();
+			defaut_moteur |= DEFAUT_BLOCAGE;
+		}
+		tournant_vus[moteur] = tournant;
+	}
+}
+
+/**
+ * @brief  accesseur du defaut moteur detecte par le watchdog analogique
+ * @param  None
+ * @retval uint8_t : 0 si aucun defaut sinon DEFAUT_SURCOURANT et/ou DEFAUT_BLOCAGE
+ */
+uint8_t pull_defaut_moteur(void){
+	return defaut_moteur;
+}
+
+/**
+ * @brief  Fonction qui efface le defaut moteur (a la remise en marche)
+ * @param  None
+ * @retval None
+ */
+void effacer_defaut_moteur(void){
+	blocage_arme[GAUCHE] = 0;
+	blocage_arme[DROITE] = 0;
+	compteur_arme[GAUCHE] = 0;
+	compteur_arme[DROITE] = 0;
+	sens_arme[GAUCHE] = ARRET;
+	sens_arme[DROITE] = ARRET;
+	defaut_moteur = 0;
+}
+/* Private functions ---------------------------------------------------------*/
 
+/**
+ * @brief  Fonction qui ajoute une conversion a la somme du moteur, avec le signe donne par
+ *         le sens de rotation, et passe au canal suivant
+ * @param  uint8_t canal : GAUCHE ou DROITE
+ *         uint16_t donnee : resultat de la conversion
+ * @retval None
+ */
+static inline void accumuler(uint8_t canal, uint16_t donnee){
+	banque_adc_t *banque = &banques[banque_active];
 
+	//Conversion du moteur gauche
+	if(canal==GAUCHE){
+		channel=DROITE;
+		//Valeur negative
+		if(BROCHE_READ(SENS_GAUCHE)){
+			banque->somme_gauche -= (int32_t)donnee;
+		}
+		//Valeur positive
+		else{
+			banque->somme_gauche += (int32_t)donnee;
+		}
+		banque->compteur_gauche+=1;
+	}
+	//Conversion du moteur droit
+	else{
+		channel=GAUCHE;
+		//Valeur negative
+		if(BROCHE_READ(SENS_DROITE)){
+			banque->somme_droite -= (int32_t)donnee;
+		}
+		//Valeur positive
+		else{
+			banque->somme_droite += (int32_t)donnee;
+		}
+		banque->compteur_droite+=1;
+	}
+}
 
+/**
+ * @brief  Fonction qui donne la banque remplie par l'interruption a la lecture et lui donne
+ *         l'autre banque, videe au changement precedent. L'interruption ne peut pas etre
+ *         au milieu d'une accumulation pendant que le programme principal s'execute : la banque
+ *         lue n'est plus ecrite apres le changement, sans masquer les interruptions
+ * @param  banque_adc_t *lue : copie des sommes de la banque rendue par l'interruption
+ * @retval None
+ */
+static void echanger_banque(banque_adc_t *lue){
+	banque_adc_t *pleine = &banques[banque_active];
+
+	banque_active ^= 1;
+	__DMB();		//la lecture de la banque n'est pas deplacee avant le changement par le compilateur
+	*lue = *pleine;
+	pleine->somme_gauche = 0;
+	pleine->somme_droite = 0;
+	pleine->compteur_gauche = 0;
+	pleine->compteur_droite = 0;
+}
 
+/**
+ * @brief  interuption de fin de conversion de l'ADC pendant la calibration : le watchdog
+ *         analogique n'est pas encore configure, on ne fait qu'accumuler
+ * @param  None
+ * @retval None
+ */
+static RAMFUNC void adc_isr_calibration(void){
+	accumuler(channel, (uint16_t)ADC1->DR);
+}
 
+/**
+ * @brief  interuption de l'ADC en veille : une conversion en cours a l'arret de l'ADC,
+ *         on efface les drapeaux sans toucher aux sommes
+ * @param  None
+ * @retval None
+ */
+static RAMFUNC void adc_isr_veille(void){
+	ADC1->ISR = ADC_ISR_EOC | ADC_ISR_EOSEQ | ADC_ISR_OVR | ADC_ISR_AWD;
+}
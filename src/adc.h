@@ -12,7 +12,41 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 /* Defines -------------------------------------------------------------------*/
-#define ADC_PRIORITY 20
+
+/* Watchdog analogique (detection de blocage et de surcourant) */
+#define ADC_AWD_MARGE_SURCOURANT 		4		//seuil haut = max calibre + max/4
+#define ADC_AWD_FRACTION_BLOCAGE 		8		//seuil bas = niveau a l'arret + pente/8
+#define ADC_AWD_CONFIRMATION_SURCOURANT 4		//nb d'echantillons consecutifs hors seuil avant la coupure
+#define ADC_AWD_CONFIRMATION_BLOCAGE 	MS_EN_TICKS(60)	//nb de ticks sans echantillon au-dessus du seuil bas avant la coupure
+#define ADC_AWD_DUTY_BLOCAGE 			0.3		//duty minimal commande pour surveiller le blocage
+#define ADC_AWD_DELAI_BLOCAGE 			MS_EN_TICKS(200)	//nb de ticks a duty eleve avant d'armer la detection de blocage
+
+/* Mesure de la zone morte des moteurs a la calibration */
+#define ZONE_MORTE_PAS 			0.02	//increment du duty entre deux mesures
+#define ZONE_MORTE_MAX 			0.5		//duty maximal essaye
+#define ZONE_MORTE_DELAI 		MS_EN_TICKS(100)	//nb de ticks de stabilisation par increment
+#define ZONE_MORTE_FRACTION 	20		//le moteur tourne si la mesure depasse l'arret de pente/20
+
+#define DEFAUT_SURCOURANT	0x01
+#define DEFAUT_BLOCAGE		0x02
+#define DEFAUT_ADC			0x04	//l'ADC n'a pas redemarre : ni mesure de vitesse ni watchdog analogique
+
+#define ADC_TIMEOUT 		10000	//nb d'essais pour ADSTP, ADDIS, ADCAL et ADRDY
+
+/* Routine d'interruption installee (adc_mode) */
+#define ADC_MODE_CALIBRATION 	0		//accumulation seulement
+#define ADC_MODE_MARCHE 		1		//accumulation et watchdog analogique
+#define ADC_MODE_VEILLE 		2		//ADC arrete, efface les drapeaux
+
+/* Type definitions ----------------------------------------------------------*/
+/* Sommes des echantillons d'un tick : l'interruption remplit une banque pendant que
+ * le controle lit l'autre (vitesse_moyenne_mesure) */
+typedef struct {
+	int32_t somme_gauche;		//somme signee des echantillons du moteur gauche
+	int32_t somme_droite;		//somme signee des echantillons du moteur droit
+	uint16_t compteur_gauche;	//nombre d'echantillons du moteur gauche
+	uint16_t compteur_droite;	//nombre d'echantillons du moteur droit
+} banque_adc_t;
 
 /* Function prototypes ------------------------------------------------------ */
 /**
@@ -22,6 +56,13 @@
  */
 void config_adc(void);
 
+/**
+ * @brief  Fonction qui installe la routine d'interruption de l'ADC du mode de fonctionnement
+ * @param  uint8_t mode : ADC_MODE_CALIBRATION, ADC_MODE_MARCHE ou ADC_MODE_VEILLE
+ * @retval None
+ */
+void adc_mode(uint8_t mode);
+
 /**
  * @brief  Fonction qui calibre les minimum et maximum de l'ADC
  * @param  None
@@ -59,5 +100,83 @@ void vitesse_mapping_init(void);
  */
 void vitesse_mapping(float* v_moyenne_gauche,float* v_moyenne_droite);
 
+/**
+ * @brief  Fonction qui mesure le duty minimal pour que chaque moteur tourne
+ * @param  None
+ * @retval None
+ */
+void mesure_zone_morte(void);
+
+/**
+ * @brief  accesseur de la zone morte des moteurs mesuree a la calibration
+ * @param  int16_t *zm_gauche : duty minimal du moteur gauche (1/10000)
+ *         int16_t *zm_droite : duty minimal du moteur droit (1/10000)
+ * @retval None
+ */
+void pull_zone_morte(int16_t *zm_gauche, int16_t *zm_droite);
+
+/**
+ * @brief  Fonction qui configure le watchdog analogique de l'ADC sur les canaux
+ *         des moteurs avec des seuils tires de la calibration
+ * @param  None
+ * @retval None
+ */
+void config_adc_watchdog(void);
+
+/**
+ * @brief  Fonction qui arme la detection de blocage des moteurs qui sont commandes
+ *         avec un duty suffisant de meme signe depuis ADC_AWD_DELAI_BLOCAGE appels, et coupe
+ *         un moteur arme qui reste sous le seuil bas pendant ADC_AWD_CONFIRMATION_BLOCAGE
+ *         ticks (a appeler a chaque tick de controle)
+ * @param  float duty_g : duty applique au moteur gauche par l'etage de sortie
+ *         float duty_d : duty applique au moteur droit par l'etage de sortie
+ * @retval None
+ */
+void adc_watchdog_armer(float duty_g, float duty_d);
+
+/**
+ * @brief  accesseur du defaut moteur detecte par le watchdog analogique
+ * @param  None
+ * @retval uint8_t : 0 si aucun defaut sinon DEFAUT_SURCOURANT et/ou DEFAUT_BLOCAGE
+ */
+uint8_t pull_defaut_moteur(void);
+
+/**
+ * @brief  Fonction qui efface le defaut moteur (a la remise en marche)
+ * @param  None
+ * @retval None
+ */
+void effacer_defaut_moteur(void);
+
+/**
+ * @brief  accesseur de la plus longue execution de l'interruption de l'ADC
+ * @param  None
+ * @retval uint16_t : duree (cycles du coeur)
+ */
+uint16_t pull_adc_cycles_max(void);
+
+/**
+ * @brief  Fonction qui remet a 0 la plus longue execution de l'interruption de l'ADC
+ * @param  None
+ * @retval None
+ */
+void effacer_adc_cycles_max(void);
+
+/**
+ * @brief  Fonction qui arrete les conversions, desactive l'ADC et coupe son horloge (mise en veille)
+ * @param  None
+ * @retval None
+ */
+void adc_suspendre(void);
+
+/**
+ * @brief  Fonction qui reactive l'horloge de l'ADC, le recalibre et relance les conversions
+ *         (les seuils du watchdog analogique sont conserves). Au timeout, le defaut DEFAUT_ADC
+ *         est leve et l'horloge de l'ADC est recoupee
+ * @param  None
+ * @retval uint8_t : 1 si l'ADC convertit de nouveau, 0 au timeout
+ */
+uint8_t adc_reprendre(void);
+
 
 #endif /* ADC_H_ */
@@ -0,0 +1,145 @@
+/**
+ ******************************************************************************
+ * File Name          : carte.h
+ * Description        : ce module contien la configuration de la carte du robot
+ * 						(frequences d'horloge, de pwm, du USART et du tick de controle,
+ * 						execution depuis la RAM, brochage et priorites des interruptions)
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+/* Ce header ne depend d'aucun header du microcontroleur pour pouvoir etre
+ * inclus par moteur.h, qui est aussi compile sur l'ordinateur hote */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef CARTE_H_
+#define CARTE_H_
+
+/* Defines -------------------------------------------------------------------*/
+#define HCLK_HZ 			48000000UL	//frequence du coeur et des peripheriques (PLL)
+#define HORLOGE_BASSE_HZ 	8000000UL	//frequence reduite (HSE ou HSI sans PLL), en arret d'urgence
+#define USART_BAUD 			9600UL		//vitesse du lien avec la telecommande
+
+#define CONTROLE_PERIODE_MS 5			//periode du tick de controle (SysTick), 1 a 10 ms
+#define PWM_FREQUENCE_HZ 	200UL		//frequence du pwm des moteurs (TIM3)
+
+#define EXEC_RAM 			1			//1 : le chemin critique s'execute depuis la RAM, 0 : depuis la flash
+
+/* Fonction copiee en RAM au demarrage (section .ramfunc, dans .data) : aucun wait state de flash.
+ * long_call : un appel de la flash (0x08000000) vers la RAM (0x20000000) depasse la portee de BL.
+ * Les appels de la RAM vers la flash passent par les veneers ajoutes par le linker. */
+#if EXEC_RAM && defined(__arm__)
+#define RAMFUNC 			__attribute__((section(".ramfunc"), long_call, noinline))
+#else
+#define RAMFUNC
+#endif
+
+/* Ports GPIO : l'adresse du port est GPIOA_BASE + port*0x400 (GPIO_PORT dans main.h) */
+#define PORT_A 				0
+#define PORT_B 				1
+#define PORT_C 				2
+#define PORT_D 				3
+
+/* Brochage : chaque broche NOM a un port NOM_PORT et un numero NOM_PIN (0 a 15) */
+#define USART_TX_PORT 		PORT_A		//USART2_TX
+#define USART_TX_PIN 		2
+#define USART_RX_PORT 		PORT_A		//USART2_RX
+#define USART_RX_PIN 		3
+#define USART_AF 			1
+
+#define I2C_SCL_PORT 		PORT_B		//I2C1_SCL
+#define I2C_SCL_PIN 		6
+#define I2C_SDA_PORT 		PORT_B		//I2C1_SDA
+#define I2C_SDA_PIN 		7
+#define I2C_AF 				1
+
+#define PWM_GAUCHE_PORT 	PORT_B		//TIM3_CH1
+#define PWM_GAUCHE_PIN 		4
+#define PWM_DROITE_PORT 	PORT_B		//TIM3_CH2
+#define PWM_DROITE_PIN 		5
+#define PWM_AF 				1
+
+#define DIRECTION_PORT 		PORT_B		//les 4 broches de sens sont ecrites en un seul BSRR
+#define DIRECTION_GAUCHE_PIN 12			//LSB, le MSB est la broche suivante
+#define DIRECTION_DROITE_PIN 14			//LSB, le MSB est la broche suivante
+
+#define MESURE_GAUCHE_PORT 	PORT_A		//entree analogique, canal de l'ADC = numero de la broche
+#define MESURE_GAUCHE_PIN 	4
+#define MESURE_DROITE_PORT 	PORT_A
+#define MESURE_DROITE_PIN 	5
+#define SENS_GAUCHE_PORT 	PORT_A		//sens de rotation mesure (1 : negatif)
+#define SENS_GAUCHE_PIN 	6
+#define SENS_DROITE_PORT 	PORT_A
+#define SENS_DROITE_PIN 	7
+#define CALIBRATION_PORT 	PORT_A		//sortie open drain, active pendant la calibration des moteurs
+#define CALIBRATION_PIN 	8
+
+#define BOUTON_MARCHE_PORT 	PORT_B		//EXTI0
+#define BOUTON_MARCHE_PIN 	0
+#define BOUTON_ARRET_PORT 	PORT_B		//EXTI1
+#define BOUTON_ARRET_PIN 	1
+
+#define DEL_UART_PORT 		PORT_C		//clignote pendant les envois au USART
+#define DEL_UART_PIN 		1
+#define DEL_OBSTACLE_DROIT_PORT 	PORT_C
+#define DEL_OBSTACLE_DROIT_PIN 		2
+#define DEL_OBSTACLE_GAUCHE_PORT 	PORT_C
+#define DEL_OBSTACLE_GAUCHE_PIN 	3
+#define DEL_PING_DROIT_PORT 		PORT_C	//mesure du sonar droit en cours
+#define DEL_PING_DROIT_PIN 			4
+#define DEL_PING_GAUCHE_PORT 		PORT_C	//mesure du sonar gauche en cours
+#define DEL_PING_GAUCHE_PIN 		5
+#define DEL_ARRET_PORT 		PORT_C		//arret d'urgence
+#define DEL_ARRET_PIN 		6
+#define DEL_MARCHE_PORT 	PORT_C
+#define DEL_MARCHE_PIN 		7
+
+/* Priorites du NVIC : 0 (la plus haute) a 3, le Cortex-M0 n'a que 2 bits de priorite */
+#define NVIC_NIVEAUX 		4
+#define PRIORITE_URGENCE 	0			//boutons : coupe les moteurs
+#define PRIORITE_ADC 		1			//fin de conversion et watchdog analogique
+#define PRIORITE_PWM 		1			//TIM3 : sens des moteurs a l'update
+#define PRIORITE_USART 		2
+#define PRIORITE_I2C 		2
+#define PRIORITE_SYSTICK 	3			//tick de controle
+
+/* Nombre de ticks de controle dans une duree en ms (arrondi vers le haut) */
+#define MS_EN_TICKS(ms) 	(((ms)+CONTROLE_PERIODE_MS-1)/CONTROLE_PERIODE_MS)
+
+#if (CONTROLE_PERIODE_MS < 1) || (CONTROLE_PERIODE_MS > 10)
+#error "CONTROLE_PERIODE_MS doit etre entre 1 et 10 ms"
+#endif
+
+#if (PWM_FREQUENCE_HZ < 50) || (PWM_FREQUENCE_HZ > 40000)
+#error "PWM_FREQUENCE_HZ doit etre entre 50 Hz et 40 kHz"
+#endif
+
+#define BROCHE_VALIDE(nom) 	((nom##_PORT) <= PORT_D && (nom##_PIN) <= 15)
+
+_Static_assert(BROCHE_VALIDE(USART_TX) && BROCHE_VALIDE(USART_RX), "broche du USART invalide");
+_Static_assert(BROCHE_VALIDE(I2C_SCL) && BROCHE_VALIDE(I2C_SDA), "broche du I2C invalide");
+_Static_assert(BROCHE_VALIDE(PWM_GAUCHE) && BROCHE_VALIDE(PWM_DROITE), "broche du pwm invalide");
+_Static_assert(DIRECTION_PORT <= PORT_D && DIRECTION_GAUCHE_PIN <= 14 && DIRECTION_DROITE_PIN <= 14,
+		"broche de direction invalide");
+_Static_assert(DIRECTION_GAUCHE_PIN + 1 < DIRECTION_DROITE_PIN || DIRECTION_DROITE_PIN + 1 < DIRECTION_GAUCHE_PIN,
+		"les paires de broches de direction se chevauchent");
+_Static_assert(MESURE_GAUCHE_PORT == PORT_A && MESURE_DROITE_PORT == PORT_A
+		&& MESURE_GAUCHE_PIN <= 7 && MESURE_DROITE_PIN <= 7, "les mesures doivent etre sur PA0 a PA7 (canaux 0 a 7)");
+_Static_assert(MESURE_GAUCHE_PIN < MESURE_DROITE_PIN, "l'ADC convertit le canal gauche avant le droit");
+_Static_assert(BROCHE_VALIDE(SENS_GAUCHE) && BROCHE_VALIDE(SENS_DROITE) && BROCHE_VALIDE(CALIBRATION),
+		"broche de mesure invalide");
+_Static_assert(BROCHE_VALIDE(BOUTON_MARCHE) && BROCHE_VALIDE(BOUTON_ARRET), "broche de bouton invalide");
+_Static_assert(BOUTON_MARCHE_PIN <= 1 && BOUTON_ARRET_PIN <= 1 && BOUTON_MARCHE_PIN != BOUTON_ARRET_PIN,
+		"les boutons utilisent les lignes EXTI0 et EXTI1 (EXTI0_1_IRQHandler)");
+_Static_assert(BROCHE_VALIDE(DEL_UART) && BROCHE_VALIDE(DEL_OBSTACLE_DROIT) && BROCHE_VALIDE(DEL_OBSTACLE_GAUCHE)
+		&& BROCHE_VALIDE(DEL_PING_DROIT) && BROCHE_VALIDE(DEL_PING_GAUCHE)
+		&& BROCHE_VALIDE(DEL_ARRET) && BROCHE_VALIDE(DEL_MARCHE), "broche de DEL invalide");
+
+_Static_assert(PRIORITE_URGENCE < NVIC_NIVEAUX && PRIORITE_ADC < NVIC_NIVEAUX && PRIORITE_PWM < NVIC_NIVEAUX
+		&& PRIORITE_USART < NVIC_NIVEAUX && PRIORITE_I2C < NVIC_NIVEAUX && PRIORITE_SYSTICK < NVIC_NIVEAUX,
+		"le Cortex-M0 n'a que 4 niveaux de priorite");
+_Static_assert(PRIORITE_URGENCE < PRIORITE_ADC && PRIORITE_URGENCE < PRIORITE_PWM && PRIORITE_URGENCE < PRIORITE_USART
+		&& PRIORITE_URGENCE < PRIORITE_I2C && PRIORITE_URGENCE < PRIORITE_SYSTICK,
+		"l'arret d'urgence doit interrompre toutes les autres routines");
+
+#endif /* CARTE_H_ */
@@ -0,0 +1,190 @@
+/**
+ * @file        chien.c
+ * @brief       Independent watchdog supervision of the periodic tasks.
+ *
+ * @details     Each supervised activity (remote parsing, control, sonar,
+ * motor update) reports with chien_signaler(). At the end of each control
+ * tick, chien_tache() checks that every required task has reported within
+ * its own deadline. The IWDG is refreshed only in that case. While the
+ * robot is e-stopped, the sonar and control tasks are not run and are
+ * removed from the required mask.
+ *
+ * A late task cuts the motors right away. The IWDG is then no longer
+ * refreshed, so it resets the MCU. If the control tick itself hangs,
+ * SysTick_Handler cuts the motors through chien_systick() while waiting
+ * for the IWDG. The missed task is kept in the .noinit section, and the
+ * next boot reports it with the RCC reset flags in a TRAME_DEMARRAGE frame.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "chien.h"
+#include "pwm.h"
+#include "telemetrie.h"
+#include "horloge.h"
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	uint32_t magique;			//CHIEN_MAGIQUE si le contenu est valide
+	uint16_t compteur;			//nb de reset par le IWDG depuis la mise sous tension
+	uint8_t manquee;			//taches en retard avant le dernier reset (CHIEN_*)
+} chien_noinit_t;
+
+/* Defines -------------------------------------------------------------------*/
+#define CHIEN_MAGIQUE 		0xC4137D06UL
+
+/* Private variables ---------------------------------------------------------*/
+static chien_noinit_t conserve __attribute__((section(".noinit")));
+
+static const uint16_t delai[CHIEN_NB_TACHES] = {
+		CHIEN_DELAI_UART, CHIEN_DELAI_CONTROLE, CHIEN_DELAI_SONAR, CHIEN_DELAI_MOTEUR
+};
+static volatile uint8_t vivantes = 0;		//taches signalees depuis le dernier tick
+static uint8_t requises = CHIEN_TOUTES;
+static uint16_t retard[CHIEN_NB_TACHES];	//nb de ticks depuis le dernier signalement
+static uint8_t actif = 0;					//1 quand le IWDG est demarre
+static volatile uint8_t echec = 0;			//1 si une tache est en retard, le IWDG n'est plus rafraichi
+static volatile uint16_t ticks_sans_tache = 0;
+
+static trame_demarrage_t demarrage;
+static uint8_t rapport_en_attente = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static void chien_echec(uint8_t taches);
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui compte les resets du watchdog et prepare le rapport de demarrage
+ * @param  uint32_t csr : RCC->CSR lu au debut de main (les drapeaux sont deja effaces)
+ * @retval None
+ */
+void chien_init(uint32_t csr){
+	if((csr & RCC_CSR_PORRSTF) || conserve.magique != CHIEN_MAGIQUE){
+		conserve.magique = CHIEN_MAGIQUE;
+		conserve.compteur = 0;
+		conserve.manquee = 0;
+	}
+	if(csr & RCC_CSR_IWDGRSTF)
+		conserve.compteur++;
+
+	demarrage.cause = (uint8_t)(csr >> 24);
+	demarrage.tache_manquee = conserve.manquee;
+	demarrage.compteur_chien = conserve.compteur;
+	demarrage.horloge = pull_horloge_source();
+	demarrage.reserve = 0;
+	rapport_en_attente = 1;
+
+	conserve.manquee = 0;
+}
+
+/**
+ * @brief  Fonction qui demarre le IWDG (apres la calibration, qui bloque plusieurs secondes)
+ * @param  None
+ * @retval None
+ */
+void chien_demarrer(void){
+	//Le IWDG s'arrete quand le debogueur arrete le processeur
+	RCC->APB2ENR |= RCC_APB2ENR_DBGMCUEN;
+	DBGMCU->APB1FZ |= DBGMCU_APB1_FZ_DBG_IWDG_STOP;
+
+	IWDG->KR = 0xCCCC;// demarre le IWDG (et le LSI)
+	IWDG->KR = 0x5555;// deverrouille PR et RLR
+	IWDG->PR = CHIEN_PR;
+	IWDG->RLR = CHIEN_RELOAD;
+	while(IWDG->SR);// le IWDG tourne deja : une attente sans fin se termine par un reset
+	IWDG->KR = 0xAAAA;
+
+	for(uint8_t i=0;i<CHIEN_NB_TACHES;i++)
+		retard[i] = 0;
+	vivantes = 0;
+	ticks_sans_tache = 0;
+	actif = 1;
+}
+
+/**
+ * @brief  Fonction qu'une tache appelle pour indiquer qu'elle est vivante
+ * @param  uint8_t tache : CHIEN_UART, CHIEN_CONTROLE, CHIEN_SONAR ou CHIEN_MOTEUR
+ * @retval None
+ */
+void chien_signaler(uint8_t tache){
+	vivantes |= tache;
+}
+
+/**
+ * @brief  Fonction qui choisit les taches dont le signalement est requis
+ *         (une tache qui redevient requise recommence avec son delai complet)
+ * @param  uint8_t taches : masque des taches requises (CHIEN_*)
+ * @retval None
+ */
+void chien_requis(uint8_t taches){
+	for(uint8_t i=0;i<CHIEN_NB_TACHES;i++){
+		if((taches & (1<<i)) && !(requises & (1<<i)))
+			retard[i] = 0;
+	}
+	requises = taches;
+}
+
+/**
+ * @brief  Fonction qui verifie les delais des taches et rafraichit le IWDG si toutes les taches
+ *         requises sont vivantes (a appeler a la fin de chaque tick). Une tache en retard coupe
+ *         les moteurs et laisse le IWDG redemarrer le microcontroleur. Envoie aussi la cause
+ *         du dernier reset sur le USART
+ * @param  None
+ * @retval None
+ */
+void chien_tache(void){
+	uint8_t signalees = vivantes;
+	uint8_t en_retard = 0;
+
+	vivantes &= ~signalees;
+	ticks_sans_tache = 0;
+
+	if(rapport_en_attente && telemetrie_envoyer(TRAME_DEMARRAGE, &demarrage, sizeof(demarrage)))
+		rapport_en_attente = 0;
+
+	if(!actif)
+		return;
+
+	for(uint8_t i=0;i<CHIEN_NB_TACHES;i++){
+		if(signalees & (1<<i))
+			retard[i] = 0;
+		else if(retard[i] < 0xFFFF)
+			retard[i]++;
+
+		if((requises & (1<<i)) && retard[i] > delai[i])
+			en_retard |= 1<<i;
+	}
+
+	if(en_retard)
+		chien_echec(en_retard);
+	if(!echec)
+		IWDG->KR = 0xAAAA;
+}
+
+/**
+ * @brief  Fonction appelee par SysTick_Handler : coupe les moteurs si le tick de controle
+ *         ne s'execute plus
+ * @param  None
+ * @retval None
+ */
+void chien_systick(void){
+	if(actif && !echec && ++ticks_sans_tache > CHIEN_DELAI_BOUCLE)
+		chien_echec(CHIEN_BOUCLE);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui coupe les moteurs, note les taches en retard et cesse de rafraichir le IWDG
+ * @param  uint8_t taches : taches en retard (CHIEN_*)
+ * @retval None
+ */
+static void chien_echec(uint8_t taches){
+	arret_moteur();
+	if(!echec)
+		conserve.manquee = taches;
+	echec = 1;
+}
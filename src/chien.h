@@ -0,0 +1,94 @@
+/**
+ ******************************************************************************
+ * File Name          : chien.h
+ * Description        : ce module gere le chien de garde independant (IWDG) : il n'est
+ * 						rafraichi que si chaque tache requise s'est signalee dans son delai
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef CHIEN_H_
+#define CHIEN_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "telemetrie_trame.h"
+/* Defines -------------------------------------------------------------------*/
+/* Taches surveillees (masque de vie) */
+#define CHIEN_UART 			0x01	//parsing de la telecommande (state_machine)
+#define CHIEN_CONTROLE 		0x02	//control_tsk
+#define CHIEN_SONAR 		0x04	//fin d'une mesure de sonar
+#define CHIEN_MOTEUR 		0x08	//mise a jour des moteurs
+#define CHIEN_BOUCLE 		0x80	//le tick de controle lui-meme ne s'execute plus
+#define CHIEN_TOUTES 		(CHIEN_UART|CHIEN_CONTROLE|CHIEN_SONAR|CHIEN_MOTEUR)
+#define CHIEN_NB_TACHES 	4
+
+/* Delai maximal entre deux signalements de chaque tache */
+#define CHIEN_DELAI_UART 		MS_EN_TICKS(20)
+#define CHIEN_DELAI_CONTROLE 	MS_EN_TICKS(20)
+#define CHIEN_DELAI_SONAR 		MS_EN_TICKS(200)	//une mesure par fenetre d'echo (77ms au plus)
+#define CHIEN_DELAI_MOTEUR 		MS_EN_TICKS(20)
+#define CHIEN_DELAI_BOUCLE 		MS_EN_TICKS(20)		//verifie par SysTick_Handler
+
+/* IWDG : LSI de 40kHz (30 a 50kHz), diviseur de 32 */
+#define CHIEN_LSI_HZ 		40000UL
+#define CHIEN_DIVISEUR 		32UL
+#define CHIEN_PR 			3						//IWDG_PR pour un diviseur de 32
+#define CHIEN_TIMEOUT_MS 	100UL
+#define CHIEN_RELOAD 		(CHIEN_LSI_HZ/CHIEN_DIVISEUR*CHIEN_TIMEOUT_MS/1000)
+
+#if (CHIEN_RELOAD < 1) || (CHIEN_RELOAD > 0xFFF)
+#error "CHIEN_TIMEOUT_MS hors de la plage de IWDG_RLR"
+#endif
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui compte les resets du watchdog et prepare le rapport de demarrage
+ * @param  uint32_t csr : RCC->CSR lu au debut de main (les drapeaux sont deja effaces)
+ * @retval None
+ */
+void chien_init(uint32_t csr);
+
+/**
+ * @brief  Fonction qui demarre le IWDG (apres la calibration, qui bloque plusieurs secondes)
+ * @param  None
+ * @retval None
+ */
+void chien_demarrer(void);
+
+/**
+ * @brief  Fonction qu'une tache appelle pour indiquer qu'elle est vivante
+ * @param  uint8_t tache : CHIEN_UART, CHIEN_CONTROLE, CHIEN_SONAR ou CHIEN_MOTEUR
+ * @retval None
+ */
+void chien_signaler(uint8_t tache);
+
+/**
+ * @brief  Fonction qui choisit les taches dont le signalement est requis
+ *         (une tache qui redevient requise recommence avec son delai complet)
+ * @param  uint8_t taches : masque des taches requises (CHIEN_*)
+ * @retval None
+ */
+void chien_requis(uint8_t taches);
+
+/**
+ * @brief  Fonction qui verifie les delais des taches et rafraichit le IWDG si toutes les taches
+ *         requises sont vivantes (a appeler a la fin de chaque tick). Une tache en retard coupe
+ *         les moteurs et laisse le IWDG redemarrer le microcontroleur. Envoie aussi la cause
+ *         du dernier reset sur le USART
+ * @param  None
+ * @retval None
+ */
+void chien_tache(void);
+
+/**
+ * @brief  Fonction appelee par SysTick_Handler : coupe les moteurs si le tick de controle
+ *         ne s'execute plus
+ * @param  None
+ * @retval None
+ */
+void chien_systick(void);
+
+#endif /* CHIEN_H_ */
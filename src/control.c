@@ -8,7 +8,12 @@
  * this structure, update its values based on UART input, and implement
  * the primary control task. The `control_tsk` function processes
  * data from the ADC and sonar sensors to adjust motor PWM outputs,
- * including a simple obstacle avoidance routine.
+ * steered and slowed by the potential-field avoidance (evitement.c).
+ * The measured wheel speeds also feed the odometry (odometrie.c). The
+ * remote setpoints reach the controller through jerk-limited profiles
+ * (trajectoire.c). While a mission runs, the setpoints come from the
+ * mission steps instead (mission.c). When the remote link is lost, the
+ * speed setpoint ramps down to zero (liaison.c).
  *
  * @author      Thomas Giguere Sturrock
  * @date        Jun 2022
@@ -19,6 +24,12 @@
 #include "control.h"
 #include "adc.h"
 #include "moteur.h"
+#include "sonar.h"
+#include "evitement.h"
+#include "odometrie.h"
+#include "trajectoire.h"
+#include "mission.h"
+#include "liaison.h"
 
 /* Public functions  ---------------------------------------------------------*/
 
@@ -39,6 +50,8 @@ void initControl(control_struct_t *control){
 	control->angle = 0;
 	control->v_moyenne_gauche = 0;
 	control->v_moyenne_droite = 0;
+	control->sequence_consigne = 0;
+	control->sequence_mesure = 0;
 
 }
 
@@ -83,8 +96,72 @@ void updateAngleUart(control_struct_t *control,float angle){
  * @retval None
  */
 void updateVitesse_angle(control_struct_t *control){
-	controlData.vitesse=(controlData.new_vitesse_uart-100.0)/100.0;
-	controlData.angle=controlData.new_angle_uart*0.034906585039887;
+	float vitesse=(controlData.new_vitesse_uart-100.0)/100.0;
+	float angle=controlData.new_angle_uart*0.034906585039887;
+
+	//Sequence impaire pendant l'ecriture : un lecteur interrompu recommence
+	controlData.sequence_consigne++;
+	__DMB();
+	controlData.vitesse=vitesse;
+	controlData.angle=angle;
+	__DMB();
+	controlData.sequence_consigne++;
+}
+
+/**
+ * @brief  accesseur de la vitesse et de l'angle : les deux valeurs viennent de la meme trame,
+ *         la lecture recommence si updateVitesse_angle l'a interrompue (sans masquer les interruptions)
+ * @param  control_struct_t *control : structure de controle a lire
+ *         float *vitesse : consigne de vitesse (-1 a 1)
+ *         float *angle : consigne d'angle (rad)
+ * @retval None
+ */
+void pullConsigne(control_struct_t *control, float *vitesse, float *angle){
+	uint16_t sequence;
+
+	do{
+		sequence = control->sequence_consigne;
+		__DMB();
+		*vitesse = control->vitesse;
+		*angle = control->angle;
+		__DMB();
+	}while((sequence & 1) || sequence != control->sequence_consigne);
+}
+
+/**
+ * @brief  met a jour les mesures moyennes de l'ADC des deux moteurs ensemble
+ * @param  control_struct_t *control : structure de controle a updater
+ *         int32_t v_gauche : mesure moyenne du moteur gauche
+ *         int32_t v_droite : mesure moyenne du moteur droit
+ * @retval None
+ */
+void updateMesure(control_struct_t *control, int32_t v_gauche, int32_t v_droite){
+	control->sequence_mesure++;
+	__DMB();
+	control->v_moyenne_gauche = v_gauche;
+	control->v_moyenne_droite = v_droite;
+	__DMB();
+	control->sequence_mesure++;
+}
+
+/**
+ * @brief  accesseur des mesures moyennes de l'ADC : les deux valeurs viennent du meme tick,
+ *         la lecture recommence si updateMesure l'a interrompue
+ * @param  control_struct_t *control : structure de controle a lire
+ *         int32_t *v_gauche : mesure moyenne du moteur gauche
+ *         int32_t *v_droite : mesure moyenne du moteur droit
+ * @retval None
+ */
+void pullMesure(control_struct_t *control, int32_t *v_gauche, int32_t *v_droite){
+	uint16_t sequence;
+
+	do{
+		sequence = control->sequence_mesure;
+		__DMB();
+		*v_gauche = control->v_moyenne_gauche;
+		*v_droite = control->v_moyenne_droite;
+		__DMB();
+	}while((sequence & 1) || sequence != control->sequence_mesure);
 }
 
 /**
@@ -115,41 +192,61 @@ float pullAngle(control_struct_t *control){
 }
 
 /**
- * @brief  fonction qui cree les fait l'asservicement en prenant en compte les obstacle
- * @param  uint8_t sonar_droit : etat a 1 si il y a un obstacle a droite sinon 0
- * 		   uint8_t sonar_gauche : etat a 1 si il y a un obstacle a gauche sinon 0
- * 		   control_struct_t *control : structure de controle a updater
+ * @brief  fonction qui fait l'asservissement en prenant en compte les obstacles : la correction
+ *         d'angle et l'echelle de vitesse viennent de l'evitement (evitement.c)
+ * @param  control_struct_t *control : structure de controle a updater
  * 		   float *Duty_G : vitesse voulue pour le moteur gauche
  * 		   float *Duty_D : vitesse voulue pour le moteur droit
  * @retval None
  */
-void control_tsk(uint8_t sonar_droit,uint8_t sonar_gauche,control_struct_t *control, float *duty_g, float *duty_d){
+void control_tsk(control_struct_t *control, float *duty_g, float *duty_d){
 
 
 	float v_moyenne_gauche=0;
 	float v_moyenne_droite=0;
 
 	float angle_corriger = 0;
+	float vitesse_corriger = 0;
+	float vitesse_consigne, angle_consigne;
+	float vitesse_profil, angle_profil;
+	uint8_t distance_g, distance_d;
+	uint16_t ttc_g, ttc_d;
+	int16_t correction_mrad;
+	uint16_t echelle;
 
 	/*
 	 * cree les vitesse de chaque moteur selon l'adc
 	 */
 	vitesse_moyenne_mesure();
 	vitesse_mapping(&v_moyenne_gauche,&v_moyenne_droite);
+	odometrie_tache((int16_t)(v_moyenne_gauche*ODOMETRIE_VMAX_MM_S),(int16_t)(v_moyenne_droite*ODOMETRIE_VMAX_MM_S));
 
 	/*
-	 * si un des sonar est activer tourne a +/-45 degree selon quelle sonar est activer sinon garde la direction normal
+	 * les consignes de la telecommande (ramenees a l'arret si la liaison est perdue, liaison.c),
+	 * ou de la mission en cours (mission.c), passent par les profils lisses (trajectoire.c)
 	 */
-	if(sonar_droit||sonar_gauche){
-		if(sonar_droit)
-			angle_corriger=controlData.angle+PI_SUR_4;//angle +45 degree
-		else
-			angle_corriger=controlData.angle-PI_SUR_4;//angle -45 degree
-	}else
-		angle_corriger =controlData.angle;
+	pullConsigne(&controlData,&vitesse_consigne,&angle_consigne);
+	liaison_consigne(&vitesse_consigne);
+	mission_tache(&vitesse_consigne,&angle_consigne);
+	trajectoire_tache(vitesse_consigne,angle_consigne);
+	pull_trajectoire(&vitesse_profil,&angle_profil);
+
+	/*
+	 * l'evitement tourne le robot selon la proximite et le temps avant collision des deux sonars
+	 * et ralentit la marche avant (la marche arriere n'est pas vue par les sonars)
+	 */
+	pull_sonar_distance(&distance_g,&distance_d);
+	pull_sonar_ttc(&ttc_g,&ttc_d,NULL,NULL);
+	evitement_calcul(distance_g,distance_d,ttc_g,ttc_d);
+	pull_evitement(&correction_mrad,&echelle);
+
+	angle_corriger = angle_profil + (float)correction_mrad*0.001f;
+	vitesse_corriger = vitesse_profil;
+	if(vitesse_corriger > 0)
+		vitesse_corriger *= (float)echelle*(1.0f/EVITEMENT_UN);
 
 
-	CalculPWM(controlData.vitesse, angle_corriger, v_moyenne_gauche, v_moyenne_droite, duty_g, duty_d);
+	CalculPWM(vitesse_corriger, angle_corriger, v_moyenne_gauche, v_moyenne_droite, duty_g, duty_d);
 }
 
 
@@ -24,11 +24,12 @@ typedef struct {
 	volatile float angle;
 	volatile int32_t v_moyenne_gauche;
 	volatile int32_t v_moyenne_droite;
+	volatile uint16_t sequence_consigne;	//impair pendant l'ecriture de vitesse et angle
+	volatile uint16_t sequence_mesure;		//impair pendant l'ecriture de v_moyenne_gauche et v_moyenne_droite
 
 } control_struct_t;
 
 /* Defines -------------------------------------------------------------------*/
-#define PI_SUR_4 (float)0.785398
 /* Type definitions ----------------------------------------------------------*/
 
 /* Function prototypes ------------------------------------------------------ */
@@ -74,6 +75,35 @@ void updateAngleUart(control_struct_t *control,float angle);
  */
 void updateVitesse_angle(control_struct_t *control);
 
+/**
+ * @brief  accesseur de la vitesse et de l'angle : les deux valeurs viennent de la meme trame,
+ *         la lecture recommence si updateVitesse_angle l'a interrompue (sans masquer les interruptions)
+ * @param  control_struct_t *control : structure de controle a lire
+ *         float *vitesse : consigne de vitesse (-1 a 1)
+ *         float *angle : consigne d'angle (rad)
+ * @retval None
+ */
+void pullConsigne(control_struct_t *control, float *vitesse, float *angle);
+
+/**
+ * @brief  met a jour les mesures moyennes de l'ADC des deux moteurs ensemble
+ * @param  control_struct_t *control : structure de controle a updater
+ *         int32_t v_gauche : mesure moyenne du moteur gauche
+ *         int32_t v_droite : mesure moyenne du moteur droit
+ * @retval None
+ */
+void updateMesure(control_struct_t *control, int32_t v_gauche, int32_t v_droite);
+
+/**
+ * @brief  accesseur des mesures moyennes de l'ADC : les deux valeurs viennent du meme tick,
+ *         la lecture recommence si updateMesure l'a interrompue
+ * @param  control_struct_t *control : structure de controle a lire
+ *         int32_t *v_gauche : mesure moyenne du moteur gauche
+ *         int32_t *v_droite : mesure moyenne du moteur droit
+ * @retval None
+ */
+void pullMesure(control_struct_t *control, int32_t *v_gauche, int32_t *v_droite);
+
 
 /**
  * @brief  accesseur de new_commande
@@ -98,14 +128,13 @@ float pullAngle(control_struct_t *control);
 
 
 /**
- * @brief  fonction qui cree les fait l'asservicement en prenant en compte les obstacle
- * @param  uint8_t sonar_droit : etat a 1 si il y a un obstacle a droite sinon 0
- * 		   uint8_t sonar_gauche : etat a 1 si il y a un obstacle a gauche sinon 0
- * 		   control_struct_t *control : structure de controle a updater
+ * @brief  fonction qui fait l'asservissement en prenant en compte les obstacles : la correction
+ *         d'angle et l'echelle de vitesse viennent de l'evitement (evitement.c)
+ * @param  control_struct_t *control : structure de controle a updater
  * 		   float *Duty_G : vitesse voulue pour le moteur gauche
  * 		   float *Duty_D : vitesse voulue pour le moteur droit
  * @retval None
  */
-void control_tsk(uint8_t sonar_droit,uint8_t sonar_Gauche,control_struct_t *control, float *Duty_G, float *Duty_D);
+void control_tsk(control_struct_t *control, float *Duty_G, float *Duty_D);
 
 #endif /* CONTROL_H_ */
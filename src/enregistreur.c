@@ -0,0 +1,216 @@
+/**
+ * @file        enregistreur.c
+ * @brief       In-RAM flight recorder of the control loop.
+ *
+ * @details     Each control tick, a compact enregistrement_vol_t (inputs,
+ * sonar states, duties and the controller's estimated angle and angular
+ * speed) is copied into a ring of ENREGISTREUR_TAILLE entries. An emergency
+ * stop, a motor fault or a command from the remote triggers the recorder:
+ * it keeps recording for ENREGISTREUR_POST ticks, then freezes.
+ *
+ * The ring lives in the .noinit section, so it survives a watchdog or
+ * software reset. A ring found valid at boot is frozen with the cause
+ * ENREG_REDEMARRAGE and kept until it has been dumped. The dump is sent
+ * one entry per frame on the telemetry channel, oldest entry first, and
+ * re-arms the recorder.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "enregistreur.h"
+#include "telemetrie.h"
+#include "etage.h"
+#include "sonar.h"
+#include "moteur.h"
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	uint32_t magique;			//ENREGISTREUR_MAGIQUE si le contenu est valide
+	uint16_t index;				//prochaine position d'ecriture
+	uint16_t nombre;			//nombre d'entrees valides
+	uint8_t cause;				//ENREG_* (ENREG_ARME si non declenche)
+	uint8_t post;				//nb de ticks a enregistrer avant le gel
+	uint8_t gele;				//1 si l'anneau n'est plus ecrit
+	uint8_t reserve;
+	enregistrement_vol_t entrees[ENREGISTREUR_TAILLE];
+} enregistreur_t;
+
+/* Private variables ---------------------------------------------------------*/
+static enregistreur_t enregistreur __attribute__((section(".noinit")));
+static uint8_t vidage_demande = 0;
+static uint8_t vidage_actif = 0;
+static uint8_t vidage_position = 0;
+static uint16_t tick = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static void enregistreur_vider(void);
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui initialise l'enregistreur au demarrage. Le contenu d'avant un reset
+ *         (watchdog, faute) est conserve jusqu'a son vidage
+ * @param  uint32_t csr : RCC->CSR lu au debut de main (les drapeaux sont deja effaces)
+ * @retval None
+ */
+void enregistreur_init(uint32_t csr){
+	uint8_t valide = (enregistreur.magique == ENREGISTREUR_MAGIQUE)
+			&& (enregistreur.index < ENREGISTREUR_TAILLE)
+			&& (enregistreur.nombre <= ENREGISTREUR_TAILLE)
+			&& !(csr & RCC_CSR_PORRSTF);	//la RAM est aleatoire a la mise sous tension
+
+	if(valide && enregistreur.nombre){
+		if(!enregistreur.gele){
+			enregistreur.gele = 1;
+			enregistreur.cause = ENREG_REDEMARRAGE;
+		}
+		enregistreur.post = 0;
+	}else{
+		enregistreur.magique = ENREGISTREUR_MAGIQUE;
+		enregistreur.index = 0;
+		enregistreur.nombre = 0;
+		enregistreur.cause = ENREG_ARME;
+		enregistreur.post = 0;
+		enregistreur.gele = 0;
+	}
+}
+
+/**
+ * @brief  Fonction qui ajoute l'etat du tick courant a l'anneau et poursuit le vidage
+ *         (a appeler a chaque tick)
+ * @param  control_struct_t *control : structure de controle
+ *         uint8_t etat_sonar_droit : etat du sonar droit
+ *         uint8_t etat_sonar_gauche : etat du sonar gauche
+ *         uint8_t arret_urgence : etat de l'arret d'urgence
+ * @retval None
+ */
+void enregistreur_tache(control_struct_t *control, uint8_t etat_sonar_droit, uint8_t etat_sonar_gauche, uint8_t arret_urgence){
+	enregistrement_vol_t entree;
+	int16_t duty_gauche, duty_droite;
+	uint8_t sonar_gauche, sonar_droit;
+	float angle_estime, w;
+	float vitesse, angle;
+	int32_t v_gauche, v_droite;
+
+	tick++;
+
+	if(vidage_demande && !vidage_actif){
+		if(enregistreur.gele){
+			vidage_demande = 0;
+			vidage_actif = 1;
+			vidage_position = 0;
+		}else{
+			enregistreur_declencher(ENREG_COMMANDE);
+		}
+	}
+	if(vidage_actif){
+		enregistreur_vider();
+	}
+
+	if(enregistreur.gele)
+		return;
+
+	pull_etage_duty(&duty_gauche, &duty_droite);
+	pull_sonar_distance(&sonar_gauche, &sonar_droit);
+	CalculPWM_Etat(&angle_estime, &w);
+
+	entree.tick = tick;
+	pullConsigne(control, &vitesse, &angle);
+	pullMesure(control, &v_gauche, &v_droite);
+	entree.vitesse = (int16_t)(vitesse*1000);
+	entree.angle = (int16_t)(angle*1000);
+	entree.v_moyenne_gauche = (int16_t)v_gauche;
+	entree.v_moyenne_droite = (int16_t)v_droite;
+	entree.duty_gauche = duty_gauche;
+	entree.duty_droite = duty_droite;
+	entree.angle_estime = (int16_t)(angle_estime*1000);
+	entree.w = (int16_t)(w*1000);
+	entree.sonar_gauche = sonar_gauche;
+	entree.sonar_droit = sonar_droit;
+	entree.drapeaux = telemetrie_drapeaux(etat_sonar_droit, etat_sonar_gauche, arret_urgence);
+	entree.commande = pullCommande(control);
+
+	memcpy(&enregistreur.entrees[enregistreur.index], &entree, sizeof(entree));
+	enregistreur.index = (enregistreur.index + 1) % ENREGISTREUR_TAILLE;
+	if(enregistreur.nombre < ENREGISTREUR_TAILLE)
+		enregistreur.nombre++;
+
+	//Apres un declenchement on garde encore ENREGISTREUR_POST ticks
+	if(enregistreur.cause != ENREG_ARME){
+		if(enregistreur.post == 0)
+			enregistreur.gele = 1;
+		else
+			enregistreur.post--;
+	}
+}
+
+/**
+ * @brief  Fonction qui declenche le gel de l'anneau apres ENREGISTREUR_POST ticks
+ * @param  uint8_t cause : cause du declenchement (ENREG_*)
+ * @retval None
+ */
+void enregistreur_declencher(uint8_t cause){
+	if(enregistreur.cause == ENREG_ARME){
+		enregistreur.cause = cause;
+		enregistreur.post = ENREGISTREUR_POST;
+	}
+}
+
+/**
+ * @brief  Fonction qui rearme l'enregistreur s'il a ete gele par un arret d'urgence ou un defaut
+ *         (le contenu d'avant un reset est garde jusqu'a son vidage)
+ * @param  None
+ * @retval None
+ */
+void enregistreur_rearmer(void){
+	if(enregistreur.cause != ENREG_REDEMARRAGE && !vidage_actif && !vidage_demande){
+		enregistreur.cause = ENREG_ARME;
+		enregistreur.post = 0;
+		enregistreur.gele = 0;
+	}
+}
+
+/**
+ * @brief  Fonction qui demande le vidage de l'anneau sur le USART (commande de la telecommande)
+ * @param  None
+ * @retval None
+ */
+void enregistreur_demande_vidage(void){
+	vidage_demande = 1;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui envoie la prochaine entree de l'anneau si le canal de telemetrie est libre
+ * @param  None
+ * @retval None
+ */
+static void enregistreur_vider(void){
+	trame_enregistreur_t trame;
+	uint16_t plus_ancienne = (enregistreur.index + ENREGISTREUR_TAILLE - enregistreur.nombre) % ENREGISTREUR_TAILLE;
+
+	if(vidage_position < enregistreur.nombre){
+		trame.index = vidage_position;
+		trame.nombre = (uint8_t)enregistreur.nombre;
+		trame.cause = enregistreur.cause;
+		trame.reserve = 0;
+		memcpy(&trame.entree, &enregistreur.entrees[(plus_ancienne + vidage_position) % ENREGISTREUR_TAILLE], sizeof(trame.entree));
+
+		if(!telemetrie_envoyer(TRAME_ENREGISTREUR, &trame, sizeof(trame)))
+			return;//le canal est occupe, on reessaie au prochain tick
+		vidage_position++;
+	}
+
+	if(vidage_position >= enregistreur.nombre){
+		//Le contenu a ete vide, on recommence a enregistrer
+		vidage_actif = 0;
+		enregistreur.nombre = 0;
+		enregistreur.cause = ENREG_ARME;
+		enregistreur.post = 0;
+		enregistreur.gele = 0;
+	}
+}
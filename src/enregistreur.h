@@ -0,0 +1,65 @@
+/**
+ ******************************************************************************
+ * File Name          : enregistreur.h
+ * Description        : ce module est l'enregistreur de vol : un anneau en RAM des derniers ticks
+ * 						de controle, conserve lors d'un reset et vide sur le USART2
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef ENREGISTREUR_H_
+#define ENREGISTREUR_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "telemetrie_trame.h"
+/* Defines -------------------------------------------------------------------*/
+#define ENREGISTREUR_TAILLE 	32					//nb de ticks conserves
+#define ENREGISTREUR_POST 		(ENREGISTREUR_TAILLE/4)	//nb de ticks enregistres apres le declenchement
+#define ENREGISTREUR_MAGIQUE 	0x5645C0DEUL
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui initialise l'enregistreur au demarrage. Le contenu d'avant un reset
+ *         (watchdog, faute) est conserve jusqu'a son vidage
+ * @param  uint32_t csr : RCC->CSR lu au debut de main (les drapeaux sont deja effaces)
+ * @retval None
+ */
+void enregistreur_init(uint32_t csr);
+
+/**
+ * @brief  Fonction qui ajoute l'etat du tick courant a l'anneau et poursuit le vidage
+ *         (a appeler a chaque tick)
+ * @param  control_struct_t *control : structure de controle
+ *         uint8_t etat_sonar_droit : etat du sonar droit
+ *         uint8_t etat_sonar_gauche : etat du sonar gauche
+ *         uint8_t arret_urgence : etat de l'arret d'urgence
+ * @retval None
+ */
+void enregistreur_tache(control_struct_t *control, uint8_t etat_sonar_droit, uint8_t etat_sonar_gauche, uint8_t arret_urgence);
+
+/**
+ * @brief  Fonction qui declenche le gel de l'anneau apres ENREGISTREUR_POST ticks
+ * @param  uint8_t cause : cause du declenchement (ENREG_*)
+ * @retval None
+ */
+void enregistreur_declencher(uint8_t cause);
+
+/**
+ * @brief  Fonction qui rearme l'enregistreur s'il a ete gele par un arret d'urgence ou un defaut
+ *         (le contenu d'avant un reset est garde jusqu'a son vidage)
+ * @param  None
+ * @retval None
+ */
+void enregistreur_rearmer(void);
+
+/**
+ * @brief  Fonction qui demande le vidage de l'anneau sur le USART (commande de la telecommande)
+ * @param  None
+ * @retval None
+ */
+void enregistreur_demande_vidage(void);
+
+#endif /* ENREGISTREUR_H_ */
@@ -0,0 +1,142 @@
+/**
+ * @file        etage.c
+ * @brief       Output stage between the controller and the PWM timer.
+ *
+ * @details     The controller duty is converted once to an integer in
+ * 1/10000 of full scale, then every step is integer arithmetic:
+ * - the motor dead-zone measured at calibration is compensated, so the
+ *   useful range of the command maps onto the range where the wheel turns;
+ * - the change of duty per control tick is limited to ETAGE_ACCEL_MAX;
+ * - a change of direction ramps down to zero and brakes the motor for
+ *   ETAGE_TICKS_FREIN ticks before driving the other way.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "etage.h"
+#include "adc.h"
+
+/* Private variables ---------------------------------------------------------*/
+static etage_moteur_t moteur_gauche;
+static etage_moteur_t moteur_droit;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t etage_moteur(etage_moteur_t *moteur, float duty);
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui initialise l'etage de sortie avec la zone morte de la calibration
+ * @param  None
+ * @retval None
+ */
+void etage_init(void){
+	pull_zone_morte(&moteur_gauche.zone_morte, &moteur_droit.zone_morte);
+	etage_reset();
+}
+
+/**
+ * @brief  Fonction qui remet les sorties a 0 (apres un arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void etage_reset(void){
+	moteur_gauche.sortie = 0;
+	moteur_gauche.ticks_frein = 0;
+	moteur_droit.sortie = 0;
+	moteur_droit.ticks_frein = 0;
+}
+
+/**
+ * @brief  Fonction qui limite, compense et applique les duty de l'asservissement (a appeler aux 5ms)
+ * @param  float duty_g : duty voulu pour le moteur gauche (-1 a 1)
+ *         float duty_d : duty voulu pour le moteur droit (-1 a 1)
+ * @retval None
+ */
+void etage_sortie(float duty_g, float duty_d){
+	uint8_t frein = 0;
+
+	if(etage_moteur(&moteur_gauche, duty_g))
+		frein |= FREIN_GAUCHE;
+	if(etage_moteur(&moteur_droit, duty_d))
+		frein |= FREIN_DROIT;
+
+	update_moteur_entier(moteur_gauche.sortie, moteur_droit.sortie, frein);
+}
+
+/**
+ * @brief  accesseur des duty appliques aux moteurs
+ * @param  int16_t *duty_g : duty applique au moteur gauche (1/10000)
+ *         int16_t *duty_d : duty applique au moteur droit (1/10000)
+ * @retval None
+ */
+void pull_etage_duty(int16_t *duty_g, int16_t *duty_d){
+	*duty_g = moteur_gauche.sortie;
+	*duty_d = moteur_droit.sortie;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui calcule la prochaine sortie d'un moteur
+ * @param  etage_moteur_t *moteur : etat de l'etage du moteur
+ *         float duty : duty voulu (-1 a 1)
+ * @retval uint8_t : 1 si le moteur doit etre freine pendant ce tick sinon 0
+ */
+static uint8_t etage_moteur(etage_moteur_t *moteur, float duty){
+	int32_t consigne = (int32_t)(duty*DUTY_PLEINE_ECHELLE);
+	int32_t amplitude = (consigne < 0) ? -consigne : consigne;
+	int32_t sortie = moteur->sortie;
+	int32_t zone_morte = moteur->zone_morte;
+
+	/*
+	 * freinage en cours au passage par zero
+	 */
+	if(moteur->ticks_frein){
+		moteur->ticks_frein--;
+		moteur->sortie = 0;
+		return 1;
+	}
+
+	/*
+	 * compensation de la zone morte : [SEUIL_ZERO, PLEINE_ECHELLE] -> [zone_morte, PLEINE_ECHELLE]
+	 */
+	if(amplitude < ETAGE_SEUIL_ZERO){
+		consigne = 0;
+	}else{
+		if(amplitude > DUTY_PLEINE_ECHELLE)
+			amplitude = DUTY_PLEINE_ECHELLE;
+		amplitude = zone_morte + (amplitude*(DUTY_PLEINE_ECHELLE-zone_morte))/DUTY_PLEINE_ECHELLE;
+		consigne = (consigne < 0) ? -amplitude : amplitude;
+	}
+
+	/*
+	 * inversion de sens : on vise d'abord zero
+	 */
+	if(((sortie > 0) && (consigne < 0)) || ((sortie < 0) && (consigne > 0))){
+		consigne = 0;
+		if(((sortie < 0) ? -sortie : sortie) <= zone_morte + ETAGE_ACCEL_MAX){
+			moteur->sortie = 0;
+			moteur->ticks_frein = ETAGE_TICKS_FREIN - 1;
+			return 1;
+		}
+	}
+
+	/*
+	 * limite d'acceleration, la zone morte est franchie d'un seul coup
+	 */
+	if(consigne > sortie + ETAGE_ACCEL_MAX)
+		consigne = sortie + ETAGE_ACCEL_MAX;
+	else if(consigne < sortie - ETAGE_ACCEL_MAX)
+		consigne = sortie - ETAGE_ACCEL_MAX;
+
+	if((consigne > 0) && (consigne < zone_morte))
+		consigne = (sortie > 0) ? 0 : zone_morte;
+	else if((consigne < 0) && (consigne > -zone_morte))
+		consigne = (sortie < 0) ? 0 : -zone_morte;
+
+	moteur->sortie = (int16_t)consigne;
+	return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ ******************************************************************************
+ * File Name          : etage.h
+ * Description        : ce module est l'etage de sortie entre l'asservissement et le pwm
+ * 						(limite d'acceleration, compensation de zone morte et freinage a l'inversion)
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef ETAGE_H_
+#define ETAGE_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "pwm.h"
+/* Defines -------------------------------------------------------------------*/
+#define ETAGE_ACCEL_PAR_S 	100000L	//variation max du duty par seconde (1/10000), 0 a 100% en 100ms
+#define ETAGE_ACCEL_MAX 	(ETAGE_ACCEL_PAR_S*CONTROLE_PERIODE_MS/1000)	//variation max par tick
+#define ETAGE_TICKS_FREIN 	MS_EN_TICKS(10)	//nb de ticks de freinage au passage par zero lors d'une inversion
+#define ETAGE_SEUIL_ZERO 	50		//consigne sous laquelle le moteur est considere a l'arret (1/10000)
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	int16_t sortie;			//duty applique au moteur (1/10000)
+	int16_t zone_morte;		//duty minimal pour que le moteur tourne (1/10000)
+	uint8_t ticks_frein;	//nb de ticks de freinage restant
+} etage_moteur_t;
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui initialise l'etage de sortie avec la zone morte de la calibration
+ * @param  None
+ * @retval None
+ */
+void etage_init(void);
+
+/**
+ * @brief  Fonction qui remet les sorties a 0 (apres un arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void etage_reset(void);
+
+/**
+ * @brief  Fonction qui limite, compense et applique les duty de l'asservissement (a appeler aux 5ms)
+ * @param  float duty_g : duty voulu pour le moteur gauche (-1 a 1)
+ *         float duty_d : duty voulu pour le moteur droit (-1 a 1)
+ * @retval None
+ */
+void etage_sortie(float duty_g, float duty_d);
+
+/**
+ * @brief  accesseur des duty appliques aux moteurs
+ * @param  int16_t *duty_g : duty applique au moteur gauche (1/10000)
+ *         int16_t *duty_d : duty applique au moteur droit (1/10000)
+ * @retval None
+ */
+void pull_etage_duty(int16_t *duty_g, int16_t *duty_d);
+
+#endif /* ETAGE_H_ */
@@ -0,0 +1,120 @@
+/**
+ * @file        evitement.c
+ * @brief       Potential-field obstacle avoidance.
+ *
+ * @details     Each sonar gives a repulsion between 0 and EVITEMENT_UN. It is
+ * the larger of two ramps: one on the filtered distance, squared so that it
+ * stays gentle far away and grows steeply near the obstacle, and one on the
+ * time to collision. The difference between the right and left repulsions
+ * sets a steering correction of up to EVITEMENT_ANGLE_MAX_MRAD away from the
+ * nearer side. The correction goes through a first-order filter, so the
+ * heading blends into the commanded one instead of jumping. The forward speed
+ * is scaled by one minus the larger repulsion. A drop in scale applies at
+ * once, and a rise is filtered. When both sides push about equally hard (a
+ * wall straight ahead), the side already being turned to is kept.
+ *
+ * Everything is integer arithmetic in 1/4096. The divisions are done at
+ * compile time (EVITEMENT_PENTE), so a call costs a few multiplications and
+ * shifts.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "evitement.h"
+
+/* Private variables ---------------------------------------------------------*/
+static evitement_t etat = { 0, 0, 0, EVITEMENT_UN };
+
+/* Private function prototypes -----------------------------------------------*/
+static int32_t repulsion(uint8_t distance, uint16_t ttc);
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui remet la correction a 0 et la vitesse a pleine echelle
+ *         (au demarrage et apres un arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void evitement_reset(void){
+	etat.repulsion_gauche = 0;
+	etat.repulsion_droit = 0;
+	etat.correction = 0;
+	etat.echelle = EVITEMENT_UN;
+}
+
+/**
+ * @brief  Fonction qui calcule la correction d'angle et l'echelle de vitesse a partir des
+ *         distances filtrees et des temps avant collision des sonars (a appeler aux 5ms)
+ * @param  uint8_t distance_gauche : distance filtree du sonar gauche (cm)
+ *         uint8_t distance_droit : distance filtree du sonar droit (cm)
+ *         uint16_t ttc_gauche : temps avant collision a gauche (ms)
+ *         uint16_t ttc_droit : temps avant collision a droite (ms)
+ * @retval None
+ */
+void evitement_calcul(uint8_t distance_gauche, uint8_t distance_droit, uint16_t ttc_gauche, uint16_t ttc_droit){
+	int32_t gauche = repulsion(distance_gauche, ttc_gauche);
+	int32_t droit = repulsion(distance_droit, ttc_droit);
+	int32_t ecart = droit - gauche;				//positif : obstacle a droite, on tourne a gauche
+	int32_t plus = (gauche > droit) ? gauche : droit;
+	int32_t cible;
+
+	etat.repulsion_gauche = (uint16_t)gauche;
+	etat.repulsion_droit = (uint16_t)droit;
+
+	//Obstacle droit devant : les deux cotes s'annulent, on garde le cote deja choisi
+	if(plus >= EVITEMENT_IMPASSE && ecart < EVITEMENT_IMPASSE_ECART && ecart > -EVITEMENT_IMPASSE_ECART)
+		ecart = (etat.correction >= 0) ? plus : -plus;
+
+	//Correction en mrad (1/16) : ecart (1/4096) * angle max >> 8
+	cible = (ecart*EVITEMENT_ANGLE_MAX_MRAD) >> (EVITEMENT_Q - 4);
+	etat.correction += (cible - etat.correction) >> EVITEMENT_LISSAGE;
+
+	//La vitesse baisse tout de suite et remonte par le filtre (arrondi vers le haut pour
+	//revenir a EVITEMENT_UN)
+	cible = EVITEMENT_UN - plus;
+	if(cible < etat.echelle)
+		etat.echelle = (uint16_t)cible;
+	else
+		etat.echelle = (uint16_t)(etat.echelle + ((cible - etat.echelle + (1 << EVITEMENT_LISSAGE) - 1) >> EVITEMENT_LISSAGE));
+}
+
+/**
+ * @brief  accesseur de la correction d'angle et de l'echelle de vitesse
+ * @param  int16_t *angle_mrad : correction a ajouter a l'angle commande (mrad, positive vers la gauche)
+ *         uint16_t *echelle : facteur de la vitesse avant commandee (1/4096)
+ * @retval None
+ */
+void pull_evitement(int16_t *angle_mrad, uint16_t *echelle){
+	*angle_mrad = (int16_t)(etat.correction >> 4);
+	*echelle = etat.echelle;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui calcule la repulsion d'un sonar : le maximum d'une rampe au carre sur
+ *         la distance et d'une rampe lineaire sur le temps avant collision
+ * @param  uint8_t distance : distance filtree (cm)
+ *         uint16_t ttc : temps avant collision (ms)
+ * @retval int32_t : repulsion (0 a EVITEMENT_UN)
+ */
+static int32_t repulsion(uint8_t distance, uint16_t ttc){
+	int32_t proche = 0;
+	int32_t urgence = 0;
+
+	if(distance < EVITEMENT_PORTEE_CM){
+		proche = ((int32_t)(EVITEMENT_PORTEE_CM - distance)*EVITEMENT_PENTE(EVITEMENT_PORTEE_CM - EVITEMENT_CONTACT_CM)) >> 4;
+		if(proche > EVITEMENT_UN)
+			proche = EVITEMENT_UN;
+		proche = (proche*proche) >> EVITEMENT_Q;
+	}
+	if(ttc < EVITEMENT_TTC_LOIN_MS){
+		urgence = ((int32_t)(EVITEMENT_TTC_LOIN_MS - ttc)*EVITEMENT_PENTE(EVITEMENT_TTC_LOIN_MS - EVITEMENT_TTC_PROCHE_MS)) >> 4;
+		if(urgence > EVITEMENT_UN)
+			urgence = EVITEMENT_UN;
+	}
+	return (proche > urgence) ? proche : urgence;
+}
@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * File Name          : evitement.h
+ * Description        : ce module calcule l'evitement d'obstacle par champ de potentiel
+ * 						(correction d'angle et reduction de vitesse selon les sonars)
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+/* Ce module n'utilise que des entiers et ne depend d'aucun header du microcontroleur */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef EVITEMENT_H_
+#define EVITEMENT_H_
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+/* Defines -------------------------------------------------------------------*/
+#define EVITEMENT_Q 				12		//repulsion et echelle de vitesse en 1/4096
+#define EVITEMENT_UN 				(1 << EVITEMENT_Q)
+#define EVITEMENT_PORTEE_CM 		150		//un objet plus loin ne repousse pas
+#define EVITEMENT_CONTACT_CM 		20		//un objet plus pres repousse au maximum
+#define EVITEMENT_TTC_LOIN_MS 		3000	//une collision prevue plus tard ne repousse pas
+#define EVITEMENT_TTC_PROCHE_MS 	500		//une collision prevue plus tot repousse au maximum
+#define EVITEMENT_ANGLE_MAX_MRAD 	785		//correction d'angle a repulsion maximale (45 degres)
+#define EVITEMENT_IMPASSE 			3072	//repulsion (1/4096) au-dela de laquelle un obstacle
+#define EVITEMENT_IMPASSE_ECART 	512		//symetrique (ecart sous cette valeur) force un cote
+#define EVITEMENT_LISSAGE 			3		//filtre du premier ordre de gain 1/8 (40ms aux 5ms)
+
+/* Pente d'une rampe lineaire de 0 a EVITEMENT_UN sur l'intervalle, en 1/16 (arrondie vers le
+ * haut pour atteindre EVITEMENT_UN) : la division est faite a la compilation */
+#define EVITEMENT_PENTE(intervalle) 	(((EVITEMENT_UN << 4) + (intervalle) - 1)/(intervalle))
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	uint16_t repulsion_gauche;	//repulsion du sonar gauche (1/4096)
+	uint16_t repulsion_droit;	//repulsion du sonar droit (1/4096)
+	int32_t correction;			//correction d'angle lissee (mrad en 1/16), positive vers la gauche
+	uint16_t echelle;			//facteur de la vitesse avant (1/4096)
+} evitement_t;
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui remet la correction a 0 et la vitesse a pleine echelle
+ *         (au demarrage et apres un arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void evitement_reset(void);
+
+/**
+ * @brief  Fonction qui calcule la correction d'angle et l'echelle de vitesse a partir des
+ *         distances filtrees et des temps avant collision des sonars (a appeler aux 5ms)
+ * @param  uint8_t distance_gauche : distance filtree du sonar gauche (cm)
+ *         uint8_t distance_droit : distance filtree du sonar droit (cm)
+ *         uint16_t ttc_gauche : temps avant collision a gauche (ms)
+ *         uint16_t ttc_droit : temps avant collision a droite (ms)
+ * @retval None
+ */
+void evitement_calcul(uint8_t distance_gauche, uint8_t distance_droit, uint16_t ttc_gauche, uint16_t ttc_droit);
+
+/**
+ * @brief  accesseur de la correction d'angle et de l'echelle de vitesse
+ * @param  int16_t *angle_mrad : correction a ajouter a l'angle commande (mrad, positive vers la gauche)
+ *         uint16_t *echelle : facteur de la vitesse avant commandee (1/4096)
+ * @retval None
+ */
+void pull_evitement(int16_t *angle_mrad, uint16_t *echelle);
+
+#endif /* EVITEMENT_H_ */
@@ -0,0 +1,107 @@
+/**
+ * @file        faute.c
+ * @brief       HardFault crash record.
+ *
+ * @details     HardFault_Handler (stm32f0xx_it.c) picks the stack that was
+ * active when the fault occurred and jumps here with the exception frame.
+ * The motors are cut first, so the last duty does not stay applied. Then
+ * the stacked registers are copied into a record in the .noinit section,
+ * and the MCU is reset. On the next boot, faute_rapport() sends the record
+ * once as a TRAME_FAUTE frame. The robot comes back in milliseconds instead
+ * of waiting for someone to power-cycle it.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "faute.h"
+#include "pwm.h"
+#include "telemetrie.h"
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	uint32_t magique;			//FAUTE_MAGIQUE si rapport contient une faute non rapportee
+	uint16_t compteur;			//nb de HardFault depuis la mise sous tension
+	trame_faute_t rapport;
+} faute_t;
+
+/* Private variables ---------------------------------------------------------*/
+static faute_t faute __attribute__((section(".noinit")));
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui valide le rapport de faute conserve au demarrage
+ *         (une mise sous tension l'efface)
+ * @param  uint32_t csr : RCC->CSR lu au debut de main (les drapeaux sont deja effaces)
+ * @retval None
+ */
+void faute_init(uint32_t csr){
+	if(csr & RCC_CSR_PORRSTF){
+		faute.magique = 0;
+		faute.compteur = 0;
+	}
+}
+
+/**
+ * @brief  Fonction qui envoie le rapport d'un HardFault precedent sur le USART2
+ *         (a appeler une fois apres l'initialisation du USART et des interruptions)
+ * @param  None
+ * @retval None
+ */
+void faute_rapport(void){
+	if(faute.magique == FAUTE_MAGIQUE){
+		if(telemetrie_envoyer(TRAME_FAUTE, &faute.rapport, sizeof(faute.rapport)))
+			faute.magique = 0;
+	}
+}
+
+/**
+ * @brief  Fonction appelee par HardFault_Handler : coupe les moteurs, capture le contexte
+ *         et redemarre le microcontroleur
+ * @param  uint32_t *pile : pile d'exception (r0, r1, r2, r3, r12, lr, pc, xpsr)
+ *         uint32_t exc_return : valeur de LR a l'entree du gestionnaire
+ * @retval None
+ */
+void faute_capture(uint32_t *pile, uint32_t exc_return){
+	uint32_t adresse = (uint32_t)(uintptr_t)pile;
+
+	//Les moteurs d'abord : le duty precharge ne doit pas rester applique
+	TIM3->CCR1 = 0;
+	TIM3->CCR2 = 0;
+	TIM3->EGR = TIM_EGR_UG;
+	arret_moteur();
+
+	//La pile peut etre la cause de la faute : on ne la lit que si elle est dans la RAM
+	if(adresse >= FAUTE_RAM_DEBUT && adresse <= FAUTE_RAM_FIN - 8*sizeof(uint32_t) && !(adresse & 3)){
+		faute.rapport.r0 = pile[0];
+		faute.rapport.r1 = pile[1];
+		faute.rapport.r2 = pile[2];
+		faute.rapport.r3 = pile[3];
+		faute.rapport.r12 = pile[4];
+		faute.rapport.lr = pile[5];
+		faute.rapport.pc = pile[6];
+		faute.rapport.xpsr = pile[7];
+		faute.rapport.pile_valide = 1;
+		//le bit 9 du xPSR empile indique un mot d'alignement ajoute par le processeur
+		faute.rapport.sp = adresse + 8*sizeof(uint32_t) + ((pile[7] & (1UL<<9)) ? 4 : 0);
+	}else{
+		faute.rapport.r0 = 0;
+		faute.rapport.r1 = 0;
+		faute.rapport.r2 = 0;
+		faute.rapport.r3 = 0;
+		faute.rapport.r12 = 0;
+		faute.rapport.lr = 0;
+		faute.rapport.pc = 0;
+		faute.rapport.xpsr = 0;
+		faute.rapport.pile_valide = 0;
+		faute.rapport.sp = adresse;
+	}
+	faute.rapport.exc_return = exc_return;
+	faute.compteur++;
+	faute.rapport.compteur = faute.compteur;
+	faute.magique = FAUTE_MAGIQUE;
+
+	NVIC_SystemReset();
+}
@@ -0,0 +1,49 @@
+/**
+ ******************************************************************************
+ * File Name          : faute.h
+ * Description        : ce module capture le contexte d'un HardFault dans la RAM conservee
+ * 						lors d'un reset et le rapporte sur le USART2 au demarrage suivant
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef FAUTE_H_
+#define FAUTE_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "telemetrie_trame.h"
+/* Defines -------------------------------------------------------------------*/
+#define FAUTE_MAGIQUE 		0xFA17C0DEUL
+#define FAUTE_RAM_DEBUT 	0x20000000UL
+#define FAUTE_RAM_FIN 		0x20002000UL	//fin des 8K de RAM (_estack)
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui valide le rapport de faute conserve au demarrage
+ *         (une mise sous tension l'efface)
+ * @param  uint32_t csr : RCC->CSR lu au debut de main (les drapeaux sont deja effaces)
+ * @retval None
+ */
+void faute_init(uint32_t csr);
+
+/**
+ * @brief  Fonction qui envoie le rapport d'un HardFault precedent sur le USART2
+ *         (a appeler une fois apres l'initialisation du USART et des interruptions)
+ * @param  None
+ * @retval None
+ */
+void faute_rapport(void);
+
+/**
+ * @brief  Fonction appelee par HardFault_Handler : coupe les moteurs, capture le contexte
+ *         et redemarre le microcontroleur
+ * @param  uint32_t *pile : pile d'exception (r0, r1, r2, r3, r12, lr, pc, xpsr)
+ *         uint32_t exc_return : valeur de LR a l'entree du gestionnaire
+ * @retval None
+ */
+void faute_capture(uint32_t *pile, uint32_t exc_return) __attribute__((noreturn));
+
+#endif /* FAUTE_H_ */
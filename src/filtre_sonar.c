@@ -0,0 +1,136 @@
+/**
+ * @file        filtre_sonar.c
+ * @brief       Range filter for one sonar, with closing speed and time to collision.
+ *
+ * @details     Each accepted reading goes into a ring of FILTRE_TAILLE
+ * values. The filtered distance is the median of the ring, computed with a
+ * seven-comparator selection network, so a single spurious echo never
+ * reaches the obstacle logic. Before a reading enters the ring, it is
+ * checked against the last accepted reading. A change larger than what
+ * FILTRE_SAUT_CM_S allows over the elapsed time is rejected. After
+ * FILTRE_REJETS_MAX rejections in a row the reading is accepted anyway,
+ * because the scene has really changed (an object stepped in or left).
+ *
+ * The closing speed is the change of the median over the elapsed time,
+ * smoothed by a first-order filter. The time to collision is the
+ * distance divided by that speed. Everything is integer: the distance in
+ * 1/16 cm, the speed in cm/s and the time in ms.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "filtre_sonar.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define TRIER(a,b) 	do{ if((a)>(b)){ uint8_t t_=(a); (a)=(b); (b)=t_; } }while(0)
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t mediane(const uint8_t *lectures);
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui vide le filtre
+ * @param  filtre_sonar_t *filtre : filtre d'un sonar
+ * @retval None
+ */
+void filtre_sonar_init(filtre_sonar_t *filtre){
+	for(uint8_t i=0;i<FILTRE_TAILLE;i++)
+		filtre->lectures[i] = 0;
+	filtre->index = 0;
+	filtre->derniere = 0;
+	filtre->rejets = 0;
+	filtre->distance = 0;
+	filtre->approche = 0;
+	filtre->ttc = FILTRE_TTC_INFINI;
+	filtre->ecoule = 0;
+	filtre->pret = 0;
+}
+
+/**
+ * @brief  Fonction qui ajoute une lecture au filtre et met a jour la distance filtree,
+ *         la vitesse d'approche et le temps avant collision
+ * @param  filtre_sonar_t *filtre : filtre d'un sonar
+ *         uint8_t distance : lecture du sonar (cm)
+ *         uint16_t dt : temps depuis la lecture precedente de ce sonar (ms)
+ * @retval uint8_t : 1 si la lecture est acceptee, 0 si elle est rejetee comme un saut
+ */
+uint8_t filtre_sonar_ajouter(filtre_sonar_t *filtre, uint8_t distance, uint16_t dt){
+	int32_t ancienne = filtre->distance;
+	int32_t saut, saut_max, vitesse, ecart;
+	uint32_t ecoule;
+
+	//La premiere lecture remplit l'historique
+	if(!filtre->pret){
+		for(uint8_t i=0;i<FILTRE_TAILLE;i++)
+			filtre->lectures[i] = distance;
+		filtre->distance = (uint16_t)distance << FILTRE_Q;
+		filtre->derniere = distance;
+		filtre->pret = 1;
+		return 1;
+	}
+
+	ecoule = (uint32_t)filtre->ecoule + dt;
+	filtre->ecoule = (ecoule > 0xFFFF) ? 0xFFFF : (uint16_t)ecoule;
+
+	//Rejet des sauts plus rapides que la vitesse relative maximale
+	saut = (int32_t)distance - (int32_t)filtre->derniere;
+	if(saut < 0)
+		saut = -saut;
+	saut_max = ((int32_t)FILTRE_SAUT_CM_S*(int32_t)filtre->ecoule)/1000 + FILTRE_BRUIT_CM;
+	if(saut > saut_max && filtre->rejets < FILTRE_REJETS_MAX){
+		filtre->rejets++;
+		return 0;
+	}
+	filtre->rejets = 0;
+	filtre->derniere = distance;
+
+	filtre->lectures[filtre->index] = distance;
+	filtre->index = (filtre->index + 1 < FILTRE_TAILLE) ? filtre->index + 1 : 0;
+	filtre->distance = (uint16_t)mediane(filtre->lectures) << FILTRE_Q;
+
+	//Vitesse d'approche en cm/s, lissee : v += (mesure - v)/2^FILTRE_LISSAGE, arrondi au plus pres
+	//des deux cotes de zero (un decalage d'un negatif arrondit vers -infini et biaise la vitesse)
+	vitesse = ((ancienne - (int32_t)filtre->distance)*1000) / ((int32_t)filtre->ecoule << FILTRE_Q);
+	ecart = vitesse - filtre->approche;
+	ecart += (ecart >= 0) ? (1 << (FILTRE_LISSAGE-1)) : -(1 << (FILTRE_LISSAGE-1));
+	filtre->approche = (int16_t)(filtre->approche + ecart/(1 << FILTRE_LISSAGE));
+	filtre->ecoule = 0;
+
+	//Temps avant collision en ms
+	if(filtre->approche > 0){
+		uint32_t ttc = ((uint32_t)filtre->distance*1000U) / ((uint32_t)filtre->approche << FILTRE_Q);
+		filtre->ttc = (ttc >= FILTRE_TTC_INFINI) ? FILTRE_TTC_INFINI - 1 : (uint16_t)ttc;
+	}else{
+		filtre->ttc = FILTRE_TTC_INFINI;
+	}
+	return 1;
+}
+
+/**
+ * @brief  accesseur de la distance filtree
+ * @param  const filtre_sonar_t *filtre : filtre d'un sonar
+ * @retval uint8_t : distance (cm, arrondie)
+ */
+uint8_t pull_filtre_distance(const filtre_sonar_t *filtre){
+	return (uint8_t)((filtre->distance + (1 << (FILTRE_Q-1))) >> FILTRE_Q);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui calcule la mediane de 5 valeurs avec un reseau de selection
+ *         de 7 comparaisons (sans boucle ni branchement dependant de l'ordre)
+ * @param  const uint8_t *lectures : les 5 valeurs
+ * @retval uint8_t : mediane
+ */
+static uint8_t mediane(const uint8_t *lectures){
+	uint8_t p0 = lectures[0], p1 = lectures[1], p2 = lectures[2], p3 = lectures[3], p4 = lectures[4];
+
+	TRIER(p0,p1); TRIER(p3,p4); TRIER(p0,p3);
+	TRIER(p1,p4); TRIER(p1,p2); TRIER(p2,p3);
+	TRIER(p1,p2);
+	return p2;
+}
@@ -0,0 +1,65 @@
+/**
+ ******************************************************************************
+ * File Name          : filtre_sonar.h
+ * Description        : ce module filtre les distances d'un sonar (mediane, rejet des sauts)
+ * 						et estime la vitesse d'approche et le temps avant collision
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+/* Ce module n'utilise que des entiers et ne depend d'aucun header du microcontroleur */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef FILTRE_SONAR_H_
+#define FILTRE_SONAR_H_
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+/* Defines -------------------------------------------------------------------*/
+#define FILTRE_TAILLE 			5		//nb de lectures de la mediane
+#define FILTRE_Q 				4		//la distance filtree est en 1/16 de cm
+#define FILTRE_SAUT_CM_S 		250		//vitesse relative maximale plausible (cm/s)
+#define FILTRE_BRUIT_CM 		6		//ecart toujours accepte entre deux lectures (cm)
+#define FILTRE_REJETS_MAX 		3		//apres 3 rejets consecutifs, la lecture est acceptee
+#define FILTRE_LISSAGE 			2		//vitesse d'approche : filtre du premier ordre de gain 1/4
+#define FILTRE_TTC_INFINI 		0xFFFF	//temps avant collision quand l'objet ne s'approche pas (ms)
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	uint8_t lectures[FILTRE_TAILLE];	//dernieres lectures acceptees (cm)
+	uint8_t index;						//prochaine case de lectures
+	uint8_t derniere;					//derniere lecture acceptee (cm)
+	uint8_t rejets;						//nb de lectures rejetees consecutives
+	uint16_t distance;					//mediane (1/16 de cm)
+	int16_t approche;					//vitesse d'approche, positive si l'objet se rapproche (cm/s)
+	uint16_t ttc;						//temps avant collision (ms)
+	uint16_t ecoule;					//temps depuis la derniere lecture acceptee (ms)
+	uint8_t pret;						//1 apres la premiere lecture
+} filtre_sonar_t;
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui vide le filtre
+ * @param  filtre_sonar_t *filtre : filtre d'un sonar
+ * @retval None
+ */
+void filtre_sonar_init(filtre_sonar_t *filtre);
+
+/**
+ * @brief  Fonction qui ajoute une lecture au filtre et met a jour la distance filtree,
+ *         la vitesse d'approche et le temps avant collision
+ * @param  filtre_sonar_t *filtre : filtre d'un sonar
+ *         uint8_t distance : lecture du sonar (cm)
+ *         uint16_t dt : temps depuis la lecture precedente de ce sonar (ms)
+ * @retval uint8_t : 1 si la lecture est acceptee, 0 si elle est rejetee comme un saut
+ */
+uint8_t filtre_sonar_ajouter(filtre_sonar_t *filtre, uint8_t distance, uint16_t dt);
+
+/**
+ * @brief  accesseur de la distance filtree
+ * @param  const filtre_sonar_t *filtre : filtre d'un sonar
+ * @retval uint8_t : distance (cm, arrondie)
+ */
+uint8_t pull_filtre_distance(const filtre_sonar_t *filtre);
+
+#endif /* FILTRE_SONAR_H_ */
@@ -0,0 +1,301 @@
+/**
+ * @file        horloge.c
+ * @brief       Clock tree manager.
+ *
+ * @details     Starts the system clock at HCLK_HZ, with the flash latency
+ * and prefetch buffer set before the switch. The PLL runs from the 8 MHz
+ * crystal (HSE). If the HSE does not start, the PLL runs from HSI/2 (the
+ * F051 has no HSI48). If the PLL does not lock, the core stays on the HSI
+ * at 8 MHz. Every ready flag is polled with a timeout. The clock security
+ * system watches the HSE: on a failure the hardware falls back to the HSI
+ * and horloge_tache() brings the PLL back from HSI/2.
+ *
+ * The frequency can be changed while running, for example down to
+ * HORLOGE_BASSE_HZ while the robot is e-stopped. After each change the
+ * USART2 BRR, I2C1 TIMINGR, TIM3 prescaler and period, and the SysTick
+ * reload are computed again from the new frequency.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "horloge.h"
+#include "usart.h"
+#include "i2c.h"
+#include "pwm.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t source = HORLOGE_HSI;
+static uint32_t frequence = 8000000UL;		//frequence actuelle (HSI apres le reset)
+static uint32_t consigne = HCLK_HZ;			//frequence demandee par horloge_changer
+static volatile uint8_t hse_perdu = 0;		//1 apres une defaillance du HSE (NMI)
+static uint16_t duree_us = 0;				//duree du dernier changement de frequence
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t attendre(volatile uint32_t *registre, uint32_t masque, uint32_t valeur);
+static uint8_t demarrer_pll(void);
+static void latence_flash(uint32_t hz);
+static void recalculer_peripheriques(void);
+static void demarrer_systick(void);
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui demarre l'horloge a HCLK_HZ : HSE et PLL, HSI/2 et PLL si le HSE ne
+ *         demarre pas, ou HSI seul si la PLL ne se verrouille pas. Configure aussi le SysTick
+ * @param  None
+ * @retval uint8_t : source de l'horloge (HORLOGE_*)
+ */
+uint8_t horloge_init(void){
+	// HCLK et PCLK a la frequence du systeme
+	RCC->CFGR &= ~(RCC_CFGR_HPRE | RCC_CFGR_PPRE);
+
+	RCC->CR &= ~RCC_CR_HSEBYP;					// quartz, pas une horloge externe
+	RCC->CR |= RCC_CR_HSEON;
+	if(attendre(&RCC->CR, RCC_CR_HSERDY, RCC_CR_HSERDY)){
+		source = HORLOGE_HSE_PLL;
+	}else{
+		RCC->CR &= ~RCC_CR_HSEON;
+		source = HORLOGE_HSI_PLL;
+	}
+
+	if(demarrer_pll()){
+		frequence = HCLK_HZ;
+		if(source == HORLOGE_HSE_PLL){
+			RCC->CR |= RCC_CR_CSSON;			// defaillance du HSE -> NMI et retour au HSI
+			RCC->CR &= ~RCC_CR_HSION;			// le HSI n'est plus utilise
+		}
+	}else{
+		source = HORLOGE_HSI;
+		frequence = HSI_VALUE;
+		latence_flash(frequence);
+	}
+
+	SystemCoreClockUpdate();	// Met a jour SystemCoreClock avec la config du RCC
+	demarrer_systick();
+	return source;
+}
+
+/**
+ * @brief  Fonction qui change la frequence du systeme et recalcule le USART, le I2C, le TIM3
+ *         et le SysTick
+ * @param  uint32_t hz : HCLK_HZ ou HORLOGE_BASSE_HZ
+ * @retval uint8_t : 1 si la frequence est appliquee, 0 sinon
+ */
+uint8_t horloge_changer(uint32_t hz){
+	uint32_t primask;
+	uint32_t ancienne = frequence;
+	uint32_t debut, cycles;
+	uint8_t succes = 1;
+
+	consigne = hz;
+	if(hz == frequence || source == HORLOGE_HSI)
+		return (hz == frequence);
+
+	//Le I2C ne peut pas finir une trame interruptions masquees : on le laisse vider son tampon
+	i2c_attendre_fin();
+	primask = __get_PRIMASK();
+	__set_PRIMASK(1);
+	debut = SysTick->VAL;
+
+	if(hz == HCLK_HZ){
+		succes = demarrer_pll();
+		if(succes)
+			frequence = HCLK_HZ;
+	}else if(hz == HORLOGE_BASSE_HZ){
+		if(source == HORLOGE_HSE_PLL && (RCC->CR & RCC_CR_HSERDY)){
+			RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSE;
+			succes = attendre(&RCC->CFGR, RCC_CFGR_SWS, RCC_CFGR_SWS_HSE);
+		}else{
+			RCC->CR |= RCC_CR_HSION;
+			attendre(&RCC->CR, RCC_CR_HSIRDY, RCC_CR_HSIRDY);
+			RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSI;
+			succes = attendre(&RCC->CFGR, RCC_CFGR_SWS, RCC_CFGR_SWS_HSI);
+		}
+		if(succes){
+			RCC->CR &= ~RCC_CR_PLLON;
+			frequence = HORLOGE_BASSE_HZ;
+			latence_flash(frequence);	// apres le changement : on descend
+		}
+	}else{
+		succes = 0;
+	}
+
+	//Le SysTick descend et est relance par recalculer_peripheriques : on lit avant
+	cycles = systick_cycles_depuis(debut);
+	duree_us = (uint16_t)(cycles/(ancienne/1000000UL));
+
+	SystemCoreClockUpdate();
+	recalculer_peripheriques();
+	__set_PRIMASK(primask);
+	return succes;
+}
+
+/**
+ * @brief  Fonction qui reprend la frequence demandee apres une defaillance du HSE
+ *         (a appeler a chaque tick)
+ * @param  None
+ * @retval None
+ */
+void horloge_tache(void){
+	uint32_t primask;
+
+	if(!hse_perdu)
+		return;
+	hse_perdu = 0;
+
+	// Le CSS a coupe le HSE et la PLL : le systeme tourne sur le HSI
+	primask = __get_PRIMASK();
+	__set_PRIMASK(1);
+	source = HORLOGE_HSI_PLL;
+	frequence = HSI_VALUE;
+	latence_flash(HCLK_HZ);
+	RCC->CR &= ~RCC_CR_HSEON;
+	if(consigne == HCLK_HZ && demarrer_pll()){
+		frequence = HCLK_HZ;
+	}else{
+		latence_flash(frequence);
+		if(consigne == HCLK_HZ)
+			source = HORLOGE_HSI;
+	}
+	SystemCoreClockUpdate();
+	recalculer_peripheriques();
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief  Fonction appelee par NMI_Handler lors d'une defaillance du HSE (CSS). Le materiel
+ *         est deja passe sur le HSI, la PLL est reconfiguree par horloge_tache
+ * @param  None
+ * @retval None
+ */
+void horloge_css(void){
+	if(RCC->CIR & RCC_CIR_CSSF){
+		RCC->CIR |= RCC_CIR_CSSC;
+		hse_perdu = 1;
+	}
+}
+
+/**
+ * @brief  accesseur de la frequence du systeme
+ * @param  None
+ * @retval uint32_t : frequence de HCLK et PCLK (Hz)
+ */
+uint32_t pull_horloge_hz(void){
+	return frequence;
+}
+
+/**
+ * @brief  accesseur de la duree du dernier changement de frequence, comptee a l'ancienne
+ *         frequence (une borne superieure quand la frequence monte)
+ * @param  None
+ * @retval uint16_t : duree (us)
+ */
+uint16_t pull_horloge_duree_us(void){
+	return duree_us;
+}
+
+/**
+ * @brief  accesseur de la source de l'horloge
+ * @param  None
+ * @retval uint8_t : HORLOGE_*
+ */
+uint8_t pull_horloge_source(void){
+	return source;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui attend qu'un registre atteigne une valeur, avec un timeout
+ * @param  volatile uint32_t *registre : registre a lire
+ *         uint32_t masque : bits a comparer
+ *         uint32_t valeur : valeur attendue des bits
+ * @retval uint8_t : 1 si la valeur est atteinte, 0 au timeout
+ */
+static uint8_t attendre(volatile uint32_t *registre, uint32_t masque, uint32_t valeur){
+	for(uint32_t essai=0;essai<HORLOGE_TIMEOUT;essai++){
+		if((*registre & masque) == valeur)
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief  Fonction qui configure la PLL a HCLK_HZ depuis la source choisie et la selectionne
+ *         comme horloge du systeme. La latence de la flash est mise avant le changement
+ * @param  None
+ * @retval uint8_t : 1 si le systeme tourne sur la PLL, 0 sinon (latence remise pour le HSI)
+ */
+static uint8_t demarrer_pll(void){
+	// la PLL ne se configure qu'arretee : on passe d'abord sur le HSI si elle est utilisee
+	if((RCC->CFGR & RCC_CFGR_SWS) == RCC_CFGR_SWS_PLL){
+		RCC->CR |= RCC_CR_HSION;
+		attendre(&RCC->CR, RCC_CR_HSIRDY, RCC_CR_HSIRDY);
+		RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSI;
+		attendre(&RCC->CFGR, RCC_CFGR_SWS, RCC_CFGR_SWS_HSI);
+	}
+	RCC->CR &= ~RCC_CR_PLLON;
+	attendre(&RCC->CR, RCC_CR_PLLRDY, 0);
+
+	RCC->CFGR &= ~(RCC_CFGR_PLLSRC | RCC_CFGR_PLLXTPRE | RCC_CFGR_PLLMUL);
+	RCC->CFGR2 &= ~RCC_CFGR2_PREDIV1;
+	if(source == HORLOGE_HSE_PLL){
+		// 48 MHz = 8MHz /1      * 6
+		RCC->CFGR |= RCC_CFGR_PLLSRC_HSE_PREDIV | RCC_CFGR_PLLMUL6;
+	}else{
+		// 48 MHz = 8MHz /2      * 12
+		RCC->CFGR |= RCC_CFGR_PLLSRC_HSI_DIV2 | RCC_CFGR_PLLMUL12;
+	}
+
+	RCC->CR |= RCC_CR_PLLON;
+	if(!attendre(&RCC->CR, RCC_CR_PLLRDY, RCC_CR_PLLRDY)){
+		RCC->CR &= ~RCC_CR_PLLON;
+		return 0;
+	}
+
+	latence_flash(HCLK_HZ);	// avant le changement : on monte
+	RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+	if(!attendre(&RCC->CFGR, RCC_CFGR_SWS, RCC_CFGR_SWS_PLL)){
+		RCC->CFGR &= ~RCC_CFGR_SW;
+		RCC->CR &= ~RCC_CR_PLLON;
+		latence_flash(HSI_VALUE);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief  Fonction qui ajuste la latence de la flash a la frequence et active le prefetch
+ * @param  uint32_t hz : frequence de HCLK
+ * @retval None
+ */
+static void latence_flash(uint32_t hz){
+	if(hz > HORLOGE_LATENCE_HZ)
+		FLASH->ACR = FLASH_ACR_PRFTBE | FLASH_ACR_LATENCY;
+	else
+		FLASH->ACR = FLASH_ACR_PRFTBE;
+}
+
+/**
+ * @brief  Fonction qui recalcule les diviseurs des peripheriques apres un changement de frequence
+ * @param  None
+ * @retval None
+ */
+static void recalculer_peripheriques(void){
+	usart_horloge(frequence);
+	i2c_horloge(frequence);
+	pwm_horloge(frequence);
+	demarrer_systick();
+}
+/**
+ * @brief  Fonction qui demarre le SysTick a CONTROLE_PERIODE_MS a la frequence actuelle
+ *         (SysTick_Config remet la priorite la plus basse, on applique celle de carte.h)
+ * @param  None
+ * @retval None
+ */
+static void demarrer_systick(void){
+	SysTick_Config(frequence/1000*CONTROLE_PERIODE_MS);
+	NVIC_SetPriority(SysTick_IRQn, PRIORITE_SYSTICK);
+}
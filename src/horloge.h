@@ -0,0 +1,77 @@
+/**
+ ******************************************************************************
+ * File Name          : horloge.h
+ * Description        : ce module gere l'arbre d'horloge (HSE, HSI, PLL, latence de la flash)
+ * 						et le changement de frequence pendant l'execution
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef HORLOGE_H_
+#define HORLOGE_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "telemetrie_trame.h"
+/* Defines -------------------------------------------------------------------*/
+#define HORLOGE_TIMEOUT 	HSE_STARTUP_TIMEOUT	//nb d'essais pour HSERDY, PLLRDY et SWS
+#define HORLOGE_LATENCE_HZ 	24000000UL			//au-dessus, la flash a besoin d'un wait state
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui demarre l'horloge a HCLK_HZ : HSE et PLL, HSI/2 et PLL si le HSE ne
+ *         demarre pas, ou HSI seul si la PLL ne se verrouille pas. Configure aussi le SysTick
+ * @param  None
+ * @retval uint8_t : source de l'horloge (HORLOGE_*)
+ */
+uint8_t horloge_init(void);
+
+/**
+ * @brief  Fonction qui change la frequence du systeme et recalcule le USART, le I2C, le TIM3
+ *         et le SysTick
+ * @param  uint32_t hz : HCLK_HZ ou HORLOGE_BASSE_HZ
+ * @retval uint8_t : 1 si la frequence est appliquee, 0 sinon
+ */
+uint8_t horloge_changer(uint32_t hz);
+
+/**
+ * @brief  Fonction qui reprend la frequence demandee apres une defaillance du HSE
+ *         (a appeler a chaque tick)
+ * @param  None
+ * @retval None
+ */
+void horloge_tache(void);
+
+/**
+ * @brief  Fonction appelee par NMI_Handler lors d'une defaillance du HSE (CSS). Le materiel
+ *         est deja passe sur le HSI, la PLL est reconfiguree par horloge_tache
+ * @param  None
+ * @retval None
+ */
+void horloge_css(void);
+
+/**
+ * @brief  accesseur de la frequence du systeme
+ * @param  None
+ * @retval uint32_t : frequence de HCLK et PCLK (Hz)
+ */
+uint32_t pull_horloge_hz(void);
+
+/**
+ * @brief  accesseur de la duree du dernier changement de frequence, comptee a l'ancienne
+ *         frequence (une borne superieure quand la frequence monte)
+ * @param  None
+ * @retval uint16_t : duree (us)
+ */
+uint16_t pull_horloge_duree_us(void);
+
+/**
+ * @brief  accesseur de la source de l'horloge
+ * @param  None
+ * @retval uint8_t : HORLOGE_*
+ */
+uint8_t pull_horloge_source(void);
+
+#endif /* HORLOGE_H_ */
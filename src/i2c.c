@@ -14,6 +14,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "i2c.h"
+#include "horloge.h"
 #include "moteur.h"
 
 // Tampon de trame du I2C
@@ -25,6 +26,8 @@ float	 	SonarMaxDistance	= MINDISTANCE;
 uint16_t	SonarObstacle[2] 	= {0, 0};
 uint8_t     *addresse_rx;
 
+static volatile uint8_t purge = 0;		//1 si le tampon a ete vide par i2c_horloge
+
 /* Private function prototypes -----------------------------------------------*/
 
 /* Public functions  ---------------------------------------------------------*/
@@ -40,45 +43,103 @@ __INLINE void Init_I2C(void) {
 
 	RCC->APB1ENR |= RCC_APB1ENR_I2C1EN;
 
-	RCC->AHBENR |= RCC_AHBENR_GPIOBEN;
+	RCC->AHBENR |= BROCHE_HORLOGE(I2C_SCL) | BROCHE_HORLOGE(I2C_SDA);
 
 	/*Disable I2C*/
 	I2C1->CR1 = (uint32_t) 0x00000000; //l'adresse indiqu�e dans la trame qui se trouve dans le tampon
 	I2C1->CR2 = (uint32_t) 0x00000000;
 
-	/* Configure GPIOB => PB6 (SCL) et PB7 (SDA) */
-	GPIO_OTYPE_CONFIG(GPIOB,6,1);
-	GPIO_OTYPE_CONFIG(GPIOB,7,1);
+	/* Configure SCL et SDA (carte.h) */
+	GPIO_OTYPE_CONFIG(BROCHE_GPIO(I2C_SCL), I2C_SCL_PIN, GPIO_OPEN_DRAIN);
+	GPIO_OTYPE_CONFIG(BROCHE_GPIO(I2C_SDA), I2C_SDA_PIN, GPIO_OPEN_DRAIN);
 
-	GPIO_MODE_CONFIG(GPIOB,6,GPIO_ALT_FUNC);
-	GPIO_MODE_CONFIG(GPIOB,7,GPIO_ALT_FUNC);
+	BROCHE_MODE(I2C_SCL, GPIO_ALT_FUNC);
+	BROCHE_MODE(I2C_SDA, GPIO_ALT_FUNC);
 
-	GPIO_ALTFUN_CONFIG(GPIOB, 6, 1);
-	GPIO_ALTFUN_CONFIG(GPIOB, 7, 1);I2CBufIn = (I2CBufIn + 1) % I2CBUFSIZE;
+	GPIO_ALTFUN_CONFIG(BROCHE_GPIO(I2C_SCL), I2C_SCL_PIN, I2C_AF);
+	GPIO_ALTFUN_CONFIG(BROCHE_GPIO(I2C_SDA), I2C_SDA_PIN, I2C_AF);
 
-	GPIOB->OSPEEDR &= ~ GPIO_OSPEEDR_OSPEEDR6_0;	//On defini la vitesse du slew rate du SCL a 2MHz
-	GPIOB->OSPEEDR &= ~ GPIO_OSPEEDR_OSPEEDR7_0;	//On defini la vitesse du slew rate du SDA a 2MHz
+	BROCHE_GPIO(I2C_SCL)->OSPEEDR &= ~(1UL<<(I2C_SCL_PIN*2));	//On defini la vitesse du slew rate du SCL a 2MHz
+	BROCHE_GPIO(I2C_SDA)->OSPEEDR &= ~(1UL<<(I2C_SDA_PIN*2));	//On defini la vitesse du slew rate du SDA a 2MHz
 
-	GPIOB->PUPDR |= (GPIO_PUPDR_PUPDR6_0 | GPIO_PUPDR_PUPDR7_0);
+	GPIO_PUPD_CONFIG(BROCHE_GPIO(I2C_SCL), I2C_SCL_PIN, PULL_UP);
+	GPIO_PUPD_CONFIG(BROCHE_GPIO(I2C_SDA), I2C_SDA_PIN, PULL_UP);
 
 
 	/* Configure I2C1, master */
-	/* Mode Standard @ 100kHz avec I2CCLK = 48MHz, rise time = 100ns, fall time = 10ns, Analog Filter ON */
-	I2C1->TIMINGR = (uint32_t) 0x10805E89;
+	/* I2CCLK = SYSCLK, le TIMINGR suit les changements de frequence (horloge.c) */
+	RCC->CFGR3 |= RCC_CFGR3_I2C1SW;
+	i2c_horloge(pull_horloge_hz());
 
 	/* Permet les interruptions */
 	I2C1->CR1 |= (I2C_CR1_TXIE | I2C_CR1_TCIE | I2C_CR1_RXIE);
 
 	/* Permet l'interruption du I2C1 dans le NVIC */
-	NVIC->ISER[0] = (((uint32_t) 1) << (I2C1_IRQn & 0x1F));
-	NVIC->IP[_IP_IDX(I2C1_IRQn)] = (NVIC->IP[_IP_IDX(I2C1_IRQn)] & ~(0xFF << _BIT_SHIFT(I2C1_IRQn))) |
-			(((I2C_PRIORITY << (8 - __NVIC_PRIO_BITS)) & 0xFF) << _BIT_SHIFT(I2C1_IRQn));
+	NVIC_SetPriority(I2C1_IRQn, PRIORITE_I2C);
+	NVIC_EnableIRQ(I2C1_IRQn);
 	/* Active le I2C1 */
 	I2C1->CR1 |= I2C_CR1_PE;
 }
 
+/**
+ * @brief  Fonction qui recalcule le TIMINGR du I2C apres un changement d'horloge (I2CCLK = SYSCLK)
+ * @param  uint32_t hz : frequence de SYSCLK (multiple de 4MHz)
+ * @retval None
+ */
+void i2c_horloge(uint32_t hz){
+	uint32_t actif = I2C1->CR1 & I2C_CR1_PE;
+
+	//On laisse finir le transfert en cours, TIMINGR ne s'ecrit que PE a 0
+	for(uint16_t essai=0;essai<I2C_TIMEOUT_BUSY && (I2C1->ISR & I2C_ISR_BUSY);essai++);
+
+	//Trame interrompue (les interruptions sont masquees, le tampon ne peut plus avancer) :
+	//on jette le tampon, sinon la trame suivante partirait du milieu de celle-ci
+	if(!i2c_termine() || (I2C1->ISR & I2C_ISR_BUSY)){
+		I2CBufOut = I2CBufIn;
+		purge = 1;
+	}
+	I2C1->CR1 &= ~I2C_CR1_PE;	//remet aussi la machine a etat du I2C a zero
+	I2C1->TIMINGR = I2C_TIMINGR_100KHZ(hz);
+	I2C1->CR1 |= actif;
+}
+
+/**
+ * @brief  Fonction qui indique si toutes les trames du tampon ont ete traitees
+ *         (la donnee d'un I2C_Read est alors ecrite a son adresse)
+ * @param  None
+ * @retval uint8_t : 1 si le tampon est vide, 0 si une trame est en cours ou en attente
+ */
+uint8_t i2c_termine(void){
+	return (I2CBufOut == I2CBufIn);
+}
+
+/**
+ * @brief  Fonction qui attend que les trames du tampon soient envoyees (interruptions permises),
+ *         avant un changement d'horloge
+ * @param  None
+ * @retval None
+ */
+void i2c_attendre_fin(void){
+	if(!(RCC->APB1ENR & RCC_APB1ENR_I2C1EN))
+		return;		//horloge du I2C coupee (veille) : rien ne peut avancer
+	for(uint32_t essai=0;essai<I2C_TIMEOUT_FIN && (!i2c_termine() || (I2C1->ISR & I2C_ISR_BUSY));essai++);
+}
+
+/**
+ * @brief  Fonction qui indique si le tampon a ete vide sans etre envoye (changement d'horloge
+ *         au milieu d'une trame) et efface l'indication
+ * @param  None
+ * @retval uint8_t : 1 si les trames en attente ont ete perdues depuis le dernier appel
+ */
+uint8_t i2c_purge(void){
+	uint8_t perdu = purge;
+
+	purge = 0;
+	return perdu;
+}
+
 
-void I2C1_IRQHandler(void) {
+RAMFUNC void I2C1_IRQHandler(void) {
 	uint32_t status;
 
 	status = I2C1->ISR;	// R�cup�re le status du I2C
@@ -14,10 +14,14 @@
 #include <stm32f0xx.h>
 #include "main.h"
 /* Defines -------------------------------------------------------------------*/
-#define I2C_PRIORITY 30
 
 #define I2CBUFSIZE			64
 #define I2C_CR2_NBYTES_POS	16
+#define I2C_TIMEOUT_BUSY 	10000	//nb d'essais avant de reconfigurer un bus occupe
+#define I2C_TIMEOUT_FIN 	50000	//nb d'essais pour vider le tampon avant un changement d'horloge (quelques ms, sous le IWDG)
+
+/* Mode Standard @ 100kHz, t_presc = 250ns : SCLDEL=4, SDADEL=2, SCLH=0x0F, SCLL=0x13 */
+#define I2C_TIMINGR_100KHZ(hz) 	((((hz)/4000000UL - 1) << 28) | 0x00420F13UL)
 
 #define RANGE_TO_ms ((float) 0.256)
 #define RANGE_TO_cm ((float) 4.43)
@@ -47,6 +51,37 @@ enum ENDIANNESS   { LSB_LITTLE_ENDIAN = 0, MSB_LITTLE_ENDIAN = 1};
  */
 void Init_I2C(void);
 
+/**
+ * @brief  Fonction qui recalcule le TIMINGR du I2C apres un changement d'horloge (I2CCLK = SYSCLK)
+ * @param  uint32_t hz : frequence de SYSCLK (multiple de 4MHz)
+ * @retval None
+ */
+void i2c_horloge(uint32_t hz);
+
+/**
+ * @brief  Fonction qui attend que les trames du tampon soient envoyees (interruptions permises),
+ *         avant un changement d'horloge
+ * @param  None
+ * @retval None
+ */
+void i2c_attendre_fin(void);
+
+/**
+ * @brief  Fonction qui indique si le tampon a ete vide sans etre envoye (changement d'horloge
+ *         au milieu d'une trame) et efface l'indication
+ * @param  None
+ * @retval uint8_t : 1 si les trames en attente ont ete perdues depuis le dernier appel
+ */
+uint8_t i2c_purge(void);
+
+/**
+ * @brief  Fonction qui indique si toutes les trames du tampon ont ete traitees
+ *         (la donnee d'un I2C_Read est alors ecrite a son adresse)
+ * @param  None
+ * @retval uint8_t : 1 si le tampon est vide, 0 si une trame est en cours ou en attente
+ */
+uint8_t i2c_termine(void);
+
 /**
  * @brief  Fonction d'ecriture de l'I2C
  * @param  uint8_t Addr : adresse d'ecriture
@@ -0,0 +1,150 @@
+/**
+ * @file        liaison.c
+ * @brief       Remote link supervision and link-loss failsafe.
+ *
+ * @details     state_machine() reports each complete speed and angle frame
+ * with liaison_trame_recue(). The silence since the last frame is counted
+ * in control ticks, also during an emergency stop. Past the configured
+ * delay the link is lost, and liaison_consigne() replaces the remote speed
+ * with a ramp that goes from the last setpoint it let through to zero at a
+ * fixed deceleration. liaison_arret() sets that setpoint to zero while the
+ * robot is stopped, so a restart on a dead link stays at zero. The heading is kept.
+ * The motors are not cut as for an emergency stop: the robot stops on a
+ * known distance, at most v^2/(2*decel) after the delay. The next frame
+ * hands the control back to the remote.
+ *
+ * The frame rate over the last second, the longest silence and the number
+ * of link losses are reported in the telemetry.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "liaison.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint16_t delai = MS_EN_TICKS(LIAISON_DELAI_MS);		//delai de perte (ticks)
+static float pas_rampe = LIAISON_DECEL*LIAISON_PERIODE_S;	//baisse de la vitesse par tick
+static uint16_t silence = 0;			//ticks depuis la derniere trame
+static uint16_t silence_max = 0;		//plus long silence depuis l'effacement (ticks)
+static uint16_t fenetre = 0;			//ticks depuis le debut de la fenetre de debit
+static uint8_t trames = 0;				//trames recues dans la fenetre
+static uint8_t debit = 0;				//trames de la derniere fenetre complete
+static uint8_t pertes = 0;
+static uint8_t etat = LIAISON_ARRET;	//vitesse nulle jusqu'a la premiere trame
+static float rampe = 0;					//vitesse de la rampe pendant une perte
+static float derniere_consigne = 0;		//derniere consigne passee au controle avant la perte
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui change le delai de perte de la liaison et la deceleration de la rampe
+ * @param  uint16_t delai_ms : silence au-dela duquel la liaison est perdue (ms)
+ *         float deceleration : deceleration de la rampe (pleine echelle par s, positive)
+ * @retval None
+ */
+void liaison_configurer(uint16_t delai_ms, float deceleration){
+	delai = MS_EN_TICKS(delai_ms);
+	pas_rampe = deceleration*LIAISON_PERIODE_S;
+}
+
+/**
+ * @brief  Fonction qui note la reception d'une trame complete de vitesse et d'angle
+ *         (appelee par state_machine)
+ * @param  None
+ * @retval None
+ */
+void liaison_trame_recue(void){
+	silence = 0;
+	etat = LIAISON_OK;
+	if(trames < 0xFF)
+		trames++;
+}
+
+/**
+ * @brief  Fonction qui compte le silence de la liaison et declare la perte apres le delai
+ *         (a appeler a chaque tick, meme en arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void liaison_tache(void){
+	if(silence < 0xFFFF)
+		silence++;
+	if(silence > silence_max)
+		silence_max = silence;
+
+	//Perte : la rampe part de la derniere consigne passee au controle
+	if(etat == LIAISON_OK && silence >= delai){
+		rampe = derniere_consigne;
+		etat = (rampe != 0) ? LIAISON_FREINAGE : LIAISON_ARRET;
+		if(pertes < 0xFF)
+			pertes++;
+	}
+
+	if(++fenetre >= LIAISON_FENETRE){
+		fenetre = 0;
+		debit = trames;
+		trames = 0;
+	}
+}
+
+/**
+ * @brief  Fonction qui limite la consigne de vitesse quand la liaison est perdue : la vitesse
+ *         descend de la derniere consigne a zero a LIAISON_DECEL (a appeler a chaque tick de controle)
+ * @param  float *vitesse : consigne de vitesse de la telecommande (-1 a 1), remplacee par la rampe
+ * @retval None
+ */
+void liaison_consigne(float *vitesse){
+	if(etat == LIAISON_OK){
+		derniere_consigne = *vitesse;
+		return;
+	}
+
+	if(rampe > pas_rampe)
+		rampe -= pas_rampe;
+	else if(rampe < -pas_rampe)
+		rampe += pas_rampe;
+	else{
+		rampe = 0;
+		etat = LIAISON_ARRET;
+	}
+	*vitesse = rampe;
+}
+
+/**
+ * @brief  Fonction qui note que les roues sont arretees (arret d'urgence) : une perte pendant
+ *         l'arret, ou une remise en marche sur une liaison perdue, reste a vitesse nulle
+ * @param  None
+ * @retval None
+ */
+void liaison_arret(void){
+	derniere_consigne = 0;
+	if(etat != LIAISON_OK){
+		rampe = 0;
+		etat = LIAISON_ARRET;
+	}
+}
+
+/**
+ * @brief  accesseur de la qualite de la liaison
+ * @param  liaison_qualite_t *qualite : debit, pertes, etat et plus long silence
+ * @retval None
+ */
+void pull_liaison_qualite(liaison_qualite_t *qualite){
+	uint32_t ms = (uint32_t)silence_max*CONTROLE_PERIODE_MS;
+
+	qualite->debit = debit;
+	qualite->pertes = pertes;
+	qualite->etat = etat;
+	qualite->silence_max = (ms > 0xFFFF) ? 0xFFFF : (uint16_t)ms;
+}
+
+/**
+ * @brief  Fonction qui efface le plus long silence (apres l'envoi de la telemetrie)
+ * @param  None
+ * @retval None
+ */
+void effacer_liaison_silence_max(void){
+	silence_max = silence;
+}
@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ * File Name          : liaison.h
+ * Description        : ce module surveille les trames de la telecommande et ramene
+ * 						la vitesse a zero sur une rampe quand la liaison est perdue
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef LIAISON_H_
+#define LIAISON_H_
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "carte.h"
+/* Defines -------------------------------------------------------------------*/
+#define LIAISON_DELAI_MS 		300		//silence au-dela duquel la liaison est perdue (ms)
+#define LIAISON_DECEL 			1.0f	//deceleration de la rampe (pleine echelle par s) : egale a TRAJ_ACCEL
+#define LIAISON_FENETRE 		MS_EN_TICKS(1000)	//fenetre de mesure du debit de trames
+#define LIAISON_PERIODE_S 		(CONTROLE_PERIODE_MS/1000.0f)
+
+/* Etat de la liaison (trame_telemetrie_t.liaison_etat) */
+#define LIAISON_OK 				0
+#define LIAISON_FREINAGE 		1		//liaison perdue, la vitesse descend sur la rampe
+#define LIAISON_ARRET 			2		//liaison perdue, vitesse nulle jusqu'a la prochaine trame
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	uint8_t debit;				//trames recues pendant la derniere fenetre (trames/s)
+	uint8_t pertes;				//nb de pertes de liaison depuis le demarrage (sature a 255)
+	uint8_t etat;				//LIAISON_*
+	uint16_t silence_max;		//plus long silence depuis le dernier effacer_liaison_silence_max (ms)
+} liaison_qualite_t;
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui change le delai de perte de la liaison et la deceleration de la rampe
+ * @param  uint16_t delai_ms : silence au-dela duquel la liaison est perdue (ms)
+ *         float deceleration : deceleration de la rampe (pleine echelle par s, positive)
+ * @retval None
+ */
+void liaison_configurer(uint16_t delai_ms, float deceleration);
+
+/**
+ * @brief  Fonction qui note la reception d'une trame complete de vitesse et d'angle
+ *         (appelee par state_machine)
+ * @param  None
+ * @retval None
+ */
+void liaison_trame_recue(void);
+
+/**
+ * @brief  Fonction qui compte le silence de la liaison et declare la perte apres le delai
+ *         (a appeler a chaque tick, meme en arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void liaison_tache(void);
+
+/**
+ * @brief  Fonction qui limite la consigne de vitesse quand la liaison est perdue : la vitesse
+ *         descend de la derniere consigne a zero a LIAISON_DECEL (a appeler a chaque tick de controle)
+ * @param  float *vitesse : consigne de vitesse de la telecommande (-1 a 1), remplacee par la rampe
+ * @retval None
+ */
+void liaison_consigne(float *vitesse);
+
+/**
+ * @brief  Fonction qui note que les roues sont arretees (arret d'urgence) : une perte pendant
+ *         l'arret, ou une remise en marche sur une liaison perdue, reste a vitesse nulle
+ * @param  None
+ * @retval None
+ */
+void liaison_arret(void);
+
+/**
+ * @brief  accesseur de la qualite de la liaison
+ * @param  liaison_qualite_t *qualite : debit, pertes, etat et plus long silence
+ * @retval None
+ */
+void pull_liaison_qualite(liaison_qualite_t *qualite);
+
+/**
+ * @brief  Fonction qui efface le plus long silence (apres l'envoi de la telemetrie)
+ * @param  None
+ * @retval None
+ */
+void effacer_liaison_silence_max(void);
+
+#endif /* LIAISON_H_ */
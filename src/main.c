@@ -7,8 +7,8 @@
  * components and implements the main control loop.
  *
  * @details     The system uses a state machine to parse commands via
- * USART2, and a SysTick interrupt handles a 5ms update
- * cycle. The robot's behavior is managed by checking for
+ * USART2, and a SysTick interrupt handles the control
+ * cycle (CONTROLE_PERIODE_MS, 5ms by default, see carte.h). The robot's behavior is managed by checking for
  * emergency stops (user buttons) and processing sensor
  * data (sonars, ADC) to control motor PWM outputs.
  *
@@ -16,7 +16,7 @@
  * and hardware configuration.
  *
  * @section     Hardware_Pinout
- * - **User Buttons:** PB0 (Start), PB1 (Emergency Stop)
+ * - **User Buttons:** PB0 (Start), PB1 (Emergency Stop), on EXTI0/EXTI1
  * - **LEDs:** PC8 (Blue), PC9 (Green), PC0-PC7 (External)
  * - **I2C1:** PB7 (SDA), PB6 (SCL)
  * - **ADC:** PA4, PA5
@@ -37,19 +37,42 @@
 #include "moteur.h"
 #include "i2c.h"
 #include "sonar.h"
-
-// Frequence des Ticks du SysTick (en Hz)
-#define MillisecondsIT ((uint32_t) 1000)
+#include "evitement.h"
+#include "odometrie.h"
+#include "trajectoire.h"
+#include "mission.h"
+#include "liaison.h"
+#include "urgence.h"
+#include "etage.h"
+#include "telemetrie.h"
+#include "enregistreur.h"
+#include "faute.h"
+#include "chien.h"
+#include "pile.h"
+#include "horloge.h"
+#include "veille.h"
+#include "vecteurs.h"
 
 /*Fonctions main*/
 void Configure_Clock(void);
 void Configure_LED(void);
-void Configure_button(void);
-void SysTick_Handler(void) {
-
+/**
+ * @brief  interuption du tick de controle (CONTROLE_PERIODE_MS)
+ * @param  None
+ * @retval None
+ */
+RAMFUNC void SysTick_Handler(void) {
+	interup_5ms = 1;//met flag d'interup a 1 pour indiquer qu'une periode de controle c'est passee
+	adc_5ms = 1;
+	counterDelay5ms++;
+	chien_systick();// coupe les moteurs si le tick de controle ne s'execute plus
 }
 
 int main(void) {
+	//Cause du reset lue puis effacee tout de suite : un reset pendant l'initialisation
+	//ne s'ajoute pas a la cause precedente, et PORRSTF ne reste pas vrai apres un reset logiciel
+	uint32_t cause_reset = RCC->CSR;
+	RCC->CSR |= RCC_CSR_RMVF;
 
 	interup_5ms=0;
 	counterDelay5ms=0;
@@ -58,62 +81,118 @@ int main(void) {
 	// Configure les composantes du robot
 	__set_PRIMASK(1);
 	/*Initialisation des peripheriques*/
+	vecteurs_init();// avant les modules qui installent leurs routines d'interruption
 	Configure_Clock();
 	Configure_LED();
+	config_urgence();
 	config_uart2();
 	config_adc();
 	initControl(&controlData);
 	init_pwm();
 	Init_I2C();
+	enregistreur_init(cause_reset);// avant la calibration, qui n'est pas enregistree
+	faute_init(cause_reset);
+	chien_init(cause_reset);
 
 
 
 	__set_PRIMASK(0);
+	faute_rapport();// rapport d'un HardFault avant le redemarrage
 
 	moteur_calibration();
+	etage_init();
+	odometrie_reset();// la pose part de l'endroit ou le robot est calibre
+	trajectoire_reset();
+	chien_demarrer();// apres la calibration, qui bloque plusieurs secondes
 
 	float duty_g =0;
 	float duty_d=0;
 	uint8_t etat_sonar_droit = 0;
 	uint8_t etat_sonar_gauche = 0;
 	uint8_t arret_urgence = 0;
+	uint8_t arret_precedent = 0;
+	uint32_t debut_controle;
+	int16_t duty_applique_g, duty_applique_d;
 
 	while (1) {
 		state_machine(&controlData);//parsing du uart
+		chien_signaler(CHIEN_UART);
 
 		if(interup_5ms){
+			(void)SysTick->CTRL;//la lecture efface COUNTFLAG, qui indiquera un depassement du tick
 
 			/*
 			 * note il faut restart avec le bouton meme si l'arret est avec la telecommande
+			 * les boutons sont traites par interruption (urgence.c), ici on ne fait que l'anti-rebond
 			 */
-			if(((GPIOB->IDR & ((uint16_t)GPIO_IDR_1))== ((uint16_t)GPIO_IDR_1))||(pullCommande(&controlData)==0xF0)){
-				arret_urgence = 1;//arret d'urgence
+			if(tache_urgence(pullCommande(&controlData)!=0xF0)){
+				effacer_defaut_moteur();//la remise en marche acquitte le defaut moteur (moteurs liberes par tache_urgence)
+				enregistreur_rearmer();
 			}
-			else if((GPIOB->IDR & ((uint16_t)GPIO_IDR_0))== ((uint16_t)GPIO_IDR_0)){
-				arret_urgence = 0;//mise en marche
+			if((pullCommande(&controlData)==0xF0)||pull_defaut_moteur()){
+				declencher_arret_urgence();//arret d'urgence par la telecommande ou defaut moteur du watchdog analogique
 			}
-
+			arret_urgence = pull_arret_urgence();
+			if(arret_urgence && !arret_precedent){
+				enregistreur_declencher(pull_defaut_moteur() ? ENREG_DEFAUT : ENREG_ARRET_URGENCE);
+				veille_entrer();// ADC et I2C coupes, frequence reduite
+			}else if(!arret_urgence && arret_precedent && !veille_sortir()){// avant le controle de ce tick
+				declencher_arret_urgence();// l'ADC n'a pas redemarre (DEFAUT_ADC) : on reste arrete
+				enregistreur_declencher(ENREG_DEFAUT);
+				arret_urgence = 1;
+			}
+			arret_precedent = arret_urgence;
+			horloge_tache();// reprise apres une defaillance du HSE
 
 			/*
 			 * activation des led d'etat et des fonction selon l'etat
 			 */
 			if(arret_urgence){
-				GPIO_SET(GPIOC,6);
-				GPIO_RESET(GPIOC,7);
+				BROCHE_SET(DEL_ARRET);
+				BROCHE_RESET(DEL_MARCHE);
+				chien_requis(CHIEN_UART|CHIEN_MOTEUR);// le sonar et le controle ne tournent pas
 				update_moteur(duty_g, duty_d,arret_urgence);// met l'arret d'urgence
+				chien_signaler(CHIEN_MOTEUR);
+				etage_reset();// la remise en marche repart de 0
+				evitement_reset();
+				odometrie_arret();// les roues sont arretees, la pose est conservee
+				trajectoire_reset();// le profil repart de l'arret et du cap estime
+				mission_abandonner();// la mission ne reprend pas a la remise en marche
+				liaison_arret();// une remise en marche sur une liaison perdue reste a l'arret
+				adc_watchdog_armer(0, 0);// desarme la detection de blocage
 			}else{
-				GPIO_SET(GPIOC,7);
-				GPIO_RESET(GPIOC,6);
-
-				task_sonar(&controlData,&etat_sonar_droit,&etat_sonar_gauche);
-				control_tsk(etat_sonar_droit,etat_sonar_gauche,&controlData,&duty_g,&duty_d);
-				update_moteur(duty_g, duty_d,arret_urgence);
+				BROCHE_SET(DEL_MARCHE);
+				BROCHE_RESET(DEL_ARRET);
+				chien_requis(CHIEN_TOUTES);
+
+				task_sonar(&etat_sonar_droit,&etat_sonar_gauche);
+				debut_controle = SysTick->VAL;
+				control_tsk(&controlData,&duty_g,&duty_d);
+				telemetrie_cycles_controle(systick_cycles_depuis(debut_controle));
+				chien_signaler(CHIEN_CONTROLE);
+				if(pull_arret_urgence()||pull_defaut_moteur()){
+					update_moteur(duty_g, duty_d,1);// un arret survenu pendant le tick garde les moteurs coupes
+				}else{
+					etage_sortie(duty_g, duty_d);// limite d'acceleration, zone morte et inversion
+				}
+				chien_signaler(CHIEN_MOTEUR);
+				//Le blocage est juge sur le duty applique (rampe, zone morte et delai d'inversion de l'etage)
+				pull_etage_duty(&duty_applique_g,&duty_applique_d);
+				adc_watchdog_armer(duty_applique_g*0.0001f, duty_applique_d*0.0001f);
 			}
 
+			enregistreur_tache(&controlData,etat_sonar_droit,etat_sonar_gauche,arret_urgence);
+			telemetrie_tache(&controlData,etat_sonar_droit,etat_sonar_gauche,arret_urgence);
+			pile_tache();
+			mission_rapport_tache();
+			liaison_tache();
+			telemetrie_duree_boucle(SysTick->LOAD - SysTick->VAL,(SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk)!=0);
+			chien_tache();// rafraichit le IWDG si toutes les taches requises sont vivantes
 
-			interup_5ms = 0;//met flag d'interup a 0 pour attendre le prochain 5ms
+			interup_5ms = 0;//met flag d'interup a 0 pour attendre le prochain tick
 
 		}
+		veille_attendre();// en arret d'urgence, dort jusqu'a la prochaine interruption
 	}
 	return (0);
 }
@@ -124,25 +203,13 @@ int main(void) {
  * @retval None
  */
 void Configure_LED(void){
-	GPIO_MODE_CONFIG(GPIOC,0,1);//set PC0 a output
-	GPIO_MODE_CONFIG(GPIOC,1,1);//set PC1 a output
-	GPIO_MODE_CONFIG(GPIOC,2,1);//set PC2 a output
-	GPIO_MODE_CONFIG(GPIOC,3,1);//set PC3 a output
-	GPIO_MODE_CONFIG(GPIOC,4,1);//set PC4 a output
-	GPIO_MODE_CONFIG(GPIOC,5,1);//set PC5 a output
-	GPIO_MODE_CONFIG(GPIOC,6,1);//set PC6 a output
-	GPIO_MODE_CONFIG(GPIOC,7,1);//set PC7 a output
-}
-
-/**
- * @brief  Fonction qui configure les bouton du robot
- * @param  None
- * @retval None
- */
-void Configure_button(void){
-	GPIO_MODE_CONFIG(GPIOB,0,0);//set Pb0 a input
-	GPIO_MODE_CONFIG(GPIOB,1,0);//set Pb1 a input
-
+	BROCHE_MODE(DEL_UART,GPIO_OUTPUT);
+	BROCHE_MODE(DEL_OBSTACLE_DROIT,GPIO_OUTPUT);
+	BROCHE_MODE(DEL_OBSTACLE_GAUCHE,GPIO_OUTPUT);
+	BROCHE_MODE(DEL_PING_DROIT,GPIO_OUTPUT);
+	BROCHE_MODE(DEL_PING_GAUCHE,GPIO_OUTPUT);
+	BROCHE_MODE(DEL_ARRET,GPIO_OUTPUT);
+	BROCHE_MODE(DEL_MARCHE,GPIO_OUTPUT);
 }
 
 /**
@@ -152,32 +219,13 @@ void Configure_button(void){
  */
 __INLINE void Configure_Clock(void){
 
-	RCC->CR |= RCC_CR_HSEON;					// On active l'horloge externe
-	RCC->CR &= ~RCC_CR_HSEBYP;					// On selectione l'horloge externe comme source
-	RCC->CR &= ~RCC_CR_HSION;					// On desactive le crystal interne
-	RCC->CFGR2 &= RCC_CFGR_PPRE_DIV1;			// On garde la frequence du signal d'horloge tel quel.
-
-	// PLLCLK = HSE  /PREDIV * PLLMUL
-	// 48 MHz = 8MHz /1      * 6
-	RCC->CFGR |= RCC_CFGR_PLLSRC_HSE_PREDIV;	// On divise la clock par 1
-	RCC->CFGR |= RCC_CFGR_PLLMUL6;				// On multiplie l'horloge par 6
-	RCC->CFGR |= RCC_CFGR_HPRE_DIV1;			// On maintient l'horloge a 48MHz pour les peripherique
-
-	RCC->CR |= RCC_CR_PLLON;		// On active le multiplicateur de frequence
-	RCC->CFGR |= RCC_CFGR_SW_PLL;	// On selectione le multiplicateur comme source d'horloge du systeme
-
-	//On attend
-	while(!RCC_CR_PLLRDY){
-	}
+	horloge_init();	// PLL a HCLK_HZ (HSE ou HSI/2), latence de la flash et SysTick
 
 	// On active l'horloge sur chaque port
 	RCC->AHBENR    |= RCC_AHBENR_GPIOAEN;
 	RCC->AHBENR    |= RCC_AHBENR_GPIOBEN;
 	RCC->AHBENR    |= RCC_AHBENR_GPIOCEN;
 	RCC->AHBENR    |= RCC_AHBENR_GPIODEN;
-
-	SystemCoreClockUpdate();	// Met a jour SystemCoreClock avec la config du RCC
-	SysTick_Config(SystemCoreClock/MillisecondsIT);	// Configure le SysTick a 1 ms
 }
 
 /*End of file*/
@@ -14,44 +14,37 @@
 #include <stddef.h>
 #include <stm32f0xx.h>
 #include <stdlib.h>
+#include "carte.h"
 #include "buffer.h"
 #include "control.h"
 #include "sonar.h"
 /*
  * GPIO config macro
  */
+#define GPIO_PORT(port) ((GPIO_TypeDef *)(GPIOA_BASE + (uint32_t)(port)*(GPIOB_BASE - GPIOA_BASE)))
 
-#define GPIO_MODE_CONFIG(PORT,PIN,MODE) PORT->MODER=(PORT->MODER &~(0x3<<(PIN*2)))|(MODE<<(PIN*2))
-#define GPIO_OTYPE_CONFIG(PORT,PIN,OTYPE) PORT->OTYPER = (PORT->OTYPER&~(1<<PIN))|(OTYPE<<PIN)
-#define GPIO_ALTFUN_CONFIG(PORT,PIN,FUN) PORT->AFR[PIN>>3]=(PORT->AFR[PIN>>3]&~(0xF<<((PIN&0x1)*4))) | (FUN<<((PIN&0X7)*4))
-#define SET_GPIO(PORT,PIN) PORT->ODR |= 1<<PIN
-#define RESET_GPIO(PORT,PIN) PORT->ODR &= ~(1<<PIN)
-#define GPIO_READ(PORT,PIN) PORT->IDR && (1<<PIN)
-
-
-#define THE_ANWSER 42
-
-#define GPIO_AVANT1(PORT,PIN) 		PORT->ODR |= ~(1010<<PIN)  		//0101
-#define GPIO_AVANT2(PORT,PIN) 		PORT->ODR &= ~(1010<<PIN)  		//0101
-
-#define GPIO_ARRIERE1(PORT,PIN) 	PORT->ODR |= (1010<<PIN) 		//1010
-#define GPIO_ARRIERE2(PORT,PIN) 	PORT->ODR &= (1010<<PIN) 		//1010
-
-#define GPIO_HORAIRE1(PORT,PIN) 	PORT->ODR |= (0110<<PIN) 		//1001
-#define GPIO_HORAIRE2(PORT,PIN) 	PORT->ODR &= (0110<<PIN) 		//1001
-
-#define GPIO_ANTI_HORAIRE1(PORT,PIN) 	PORT->ODR |= (0110<<PIN) 	//0110
-#define GPIO_ANTI_HORAIRE2(PORT,PIN) 	PORT->ODR &= (0110<<PIN) 	//0110
-
-#define GPIO_ARRET(PORT,PIN) 		PORT->ODR |= (1111<<PIN)		//11
-#define GPIO_NEUTRE(PORT,PIN) 		PORT->ODR &= ~(1111<<PIN)		//00
+#define GPIO_MODE_CONFIG(PORT,PIN,MODE) ((PORT)->MODER = ((PORT)->MODER & ~(0x3UL<<((PIN)*2))) | ((uint32_t)(MODE)<<((PIN)*2)))
+#define GPIO_OTYPE_CONFIG(PORT,PIN,OTYPE) ((PORT)->OTYPER = ((PORT)->OTYPER & ~(1UL<<(PIN))) | ((uint32_t)(OTYPE)<<(PIN)))
+#define GPIO_PUPD_CONFIG(PORT,PIN,PUPD) ((PORT)->PUPDR = ((PORT)->PUPDR & ~(0x3UL<<((PIN)*2))) | ((uint32_t)(PUPD)<<((PIN)*2)))
+#define GPIO_ALTFUN_CONFIG(PORT,PIN,FUN) ((PORT)->AFR[(PIN)>>3] = ((PORT)->AFR[(PIN)>>3] & ~(0xFUL<<(((PIN)&0x7)*4))) | ((uint32_t)(FUN)<<(((PIN)&0x7)*4)))
 
 /*
  * GPIO control macro
  */
-#define BITS_DIRECTION 12
-#define GPIO_SET(PORT,PIN) PORT->ODR |= 1<<PIN
-#define GPIO_RESET(PORT,PIN) PORT->ODR &= ~(1<<PIN)
+#define GPIO_SET(PORT,PIN) ((PORT)->BSRR = 1UL<<(PIN))
+#define GPIO_RESET(PORT,PIN) ((PORT)->BRR = 1UL<<(PIN))
+#define GPIO_READ(PORT,PIN) (((PORT)->IDR >> (PIN)) & 1UL)
+
+/*
+ * Acces a une broche de carte.h par son nom (NOM_PORT et NOM_PIN)
+ */
+#define BROCHE_GPIO(nom) GPIO_PORT(nom##_PORT)
+#define BROCHE_MASQUE(nom) (1UL<<(nom##_PIN))
+#define BROCHE_MODE(nom,MODE) GPIO_MODE_CONFIG(BROCHE_GPIO(nom), nom##_PIN, MODE)
+#define BROCHE_SET(nom) GPIO_SET(BROCHE_GPIO(nom), nom##_PIN)
+#define BROCHE_RESET(nom) GPIO_RESET(BROCHE_GPIO(nom), nom##_PIN)
+#define BROCHE_READ(nom) GPIO_READ(BROCHE_GPIO(nom), nom##_PIN)
+#define BROCHE_HORLOGE(nom) (RCC_AHBENR_GPIOAEN << (nom##_PORT))
 
 
 #define GPIO_INPUT 0b0
@@ -63,8 +56,19 @@
 #define PULL_UP 0b1
 #define PULL_DOWN 0b10
 
+#define GPIO_PUSH_PULL 0
+#define GPIO_OPEN_DRAIN 1
+
 
 
+/*
+ * Nombre de cycles ecoules depuis une lecture de SysTick->VAL (moins d'une periode de SysTick)
+ */
+static inline uint32_t systick_cycles_depuis(uint32_t debut){
+	uint32_t valeur = SysTick->VAL;
+	return (debut >= valeur) ? (debut - valeur) : (debut + SysTick->LOAD + 1 - valeur);
+}
+
 control_struct_t controlData;
 uint16_t interup_5ms;
 uint8_t adc_5ms;
@@ -0,0 +1,341 @@
+/**
+ * @file        mission.c
+ * @brief       Waypoint mission mode.
+ *
+ * @details     A list of steps (go to a point, turn to a heading, wait) is
+ * uploaded over USART2 with command 0xF4 (format in mission.h) and kept in
+ * a RAM table of MISSION_ETAPES_MAX entries. The upload is checked with an
+ * 8-bit sum. Command 0xF5 starts it from the current pose. The points and
+ * headings are given in the robot frame at the start, then turned into the
+ * odometry frame one step at a time.
+ *
+ * While a mission runs, mission_tache() replaces the remote setpoints of
+ * control_tsk. The speed and heading go through the same trajectory
+ * profiles, avoidance and controller as remote driving, so the link
+ * latency is out of the loop. A point is driven at with the heading
+ * toward it. The speed drops when the heading is off and on the final
+ * approach. The step ends within MISSION_ARRIVEE_MM.
+ *
+ * Command 0xF6 or an emergency stop aborts the mission. When the last
+ * step is reached the remote setpoints are used again. Each event
+ * (received, refused, start, step reached, finished, aborted) is queued
+ * and sent as a TRAME_MISSION frame with the pose at that moment.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include "mission.h"
+#include "odometrie.h"
+#include "moteur.h"
+#include "telemetrie.h"
+#include "urgence.h"
+
+/* Private variables ---------------------------------------------------------*/
+static mission_etape_t etapes[MISSION_ETAPES_MAX];
+static uint8_t nombre = 0;					//nb d'etapes de la mission recue (0 : aucune)
+static uint8_t vitesse_pourcent = 0;		//vitesse de la mission (% de la pleine vitesse)
+
+/* Reception de la commande 0xF4 */
+static uint8_t reception_position = 0;		//octets recus apres 0xF4
+static uint8_t reception_nombre = 0;
+static uint8_t reception_vitesse = 0;
+static uint8_t reception_somme = 0;
+static uint8_t reception_etape[MISSION_OCTETS_ETAPE];
+
+/* Execution */
+static uint8_t active = 0;
+static uint8_t etape = 0;					//etape en cours
+static float origine_x, origine_y;			//pose au depart (mm, rad)
+static float origine_theta;
+static float cible_x, cible_y;				//point vise (mm, repere de l'odometrie)
+static float cap_cible;						//cap vise ou tenu (rad)
+static uint16_t compteur = 0;				//ticks depuis le debut de l'attente ou cap tenu
+static uint16_t distance_cm = 0;			//distance restante au point vise
+
+/* Evenements a envoyer : paires (evenement, etape) */
+static uint8_t evenements_data[MISSION_EVENEMENTS*2];
+static buffer_t evenements = { .data = evenements_data, .size = MISSION_EVENEMENTS*2 };
+static uint8_t evenement_en_attente = 0;	//1 si evenement_trame attend le canal de telemetrie
+static trame_mission_t evenement_trame;
+
+/* Private function prototypes -----------------------------------------------*/
+static void preparer_etape(void);
+static void etape_suivante(void);
+static void signaler(uint8_t evenement, uint8_t numero);
+static float ecart_angle(float ecart);
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui prepare la reception d'une mission (commande 0xF4)
+ * @param  None
+ * @retval None
+ */
+void mission_debut_reception(void){
+	reception_position = 0;
+	reception_somme = 0;
+}
+
+/**
+ * @brief  Fonction qui recoit un octet de la commande 0xF4 (appelee par state_machine)
+ * @param  uint8_t octet : octet recu apres 0xF4
+ * @retval uint8_t : 1 quand la commande est finie (acceptee ou refusee), 0 s'il manque des octets
+ */
+uint8_t mission_recevoir(uint8_t octet){
+	uint8_t position = reception_position++;
+	uint16_t fin;
+
+	if(position == 0){
+		if(octet == 0 || octet > MISSION_ETAPES_MAX){
+			signaler(MISSION_REFUSEE, 0);
+			return 1;
+		}
+		reception_nombre = octet;
+		if(!active)
+			nombre = 0;			//la mission precedente est remplacee
+		reception_somme = octet;
+		return 0;
+	}
+
+	fin = 2 + (uint16_t)reception_nombre*MISSION_OCTETS_ETAPE;
+	if(position < fin){
+		reception_somme += octet;
+		if(position == 1){
+			reception_vitesse = (octet > 100) ? 100 : octet;
+			return 0;
+		}
+		//Etapes : la table n'est ecrite que si aucune mission n'est en cours
+		reception_etape[(position - 2) % MISSION_OCTETS_ETAPE] = octet;
+		if((position - 2) % MISSION_OCTETS_ETAPE == MISSION_OCTETS_ETAPE - 1 && !active){
+			mission_etape_t *e = &etapes[(position - 2)/MISSION_OCTETS_ETAPE];
+			e->type = reception_etape[0];
+			e->a = (int16_t)(reception_etape[1] | (reception_etape[2] << 8));
+			e->b = (int16_t)(reception_etape[3] | (reception_etape[4] << 8));
+		}
+		return 0;
+	}
+
+	//Somme de controle
+	if(octet == reception_somme && !active){
+		nombre = reception_nombre;
+		vitesse_pourcent = reception_vitesse;
+		signaler(MISSION_RECUE, 0);
+	}else{
+		signaler(MISSION_REFUSEE, 0);
+	}
+	return 1;
+}
+
+/**
+ * @brief  Fonction qui demarre la mission recue depuis la pose actuelle (commande 0xF5)
+ * @param  None
+ * @retval None
+ */
+void mission_demarrer(void){
+	odometrie_pose_t pose;
+
+	if(active || nombre == 0 || pull_arret_urgence()){
+		signaler(MISSION_REFUSEE, etape);
+		return;
+	}
+	pull_odometrie_pose(&pose);
+	origine_x = (float)pose.x;
+	origine_y = (float)pose.y;
+	origine_theta = (float)pull_odometrie_theta_mrad()*0.001f;
+	etape = 0;
+	active = 1;
+	signaler(MISSION_DEPART, 0);
+	preparer_etape();
+}
+
+/**
+ * @brief  Fonction qui abandonne la mission en cours (commande 0xF6 ou arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void mission_abandonner(void){
+	if(!active)
+		return;
+	active = 0;
+	signaler(MISSION_ABANDON, etape);
+}
+
+/**
+ * @brief  Fonction qui execute la mission : remplace les consignes de la telecommande
+ *         pendant une mission (a appeler a chaque tick de controle)
+ * @param  float *vitesse : consigne de vitesse (-1 a 1), remplacee pendant une mission
+ *         float *angle : consigne d'angle (rad), remplacee pendant une mission
+ * @retval None
+ */
+void mission_tache(float *vitesse, float *angle){
+	const mission_etape_t *e;
+	odometrie_pose_t pose;
+	float theta, dx, dy, distance, ecart, v, angle_controleur, w;
+
+	if(!active)
+		return;
+
+	e = &etapes[etape];
+	pull_odometrie_pose(&pose);
+	theta = (float)pull_odometrie_theta_mrad()*0.001f;
+	v = 0;
+
+	switch(e->type){
+	case ETAPE_POINT:
+		dx = cible_x - (float)pose.x;
+		dy = cible_y - (float)pose.y;
+		distance = sqrtf(dx*dx + dy*dy);
+		distance_cm = (distance > 655350.0f) ? 0xFFFF : (uint16_t)(distance*0.1f);
+		if(distance < MISSION_ARRIVEE_MM){
+			etape_suivante();
+			break;
+		}
+		//Cap vers le point, vitesse reduite si le cap est loin et pres de l'arrivee
+		cap_cible = atan2f(dy, dx);
+		ecart = fabsf(ecart_angle(cap_cible - theta));
+		v = vitesse_pourcent*0.01f;
+		if(v > distance*MISSION_FREIN_PAR_MM)
+			v = (distance*MISSION_FREIN_PAR_MM > MISSION_VITESSE_MIN) ? distance*MISSION_FREIN_PAR_MM : MISSION_VITESSE_MIN;
+		v = (ecart < MISSION_CAP_ARRET) ? v*(1.0f - ecart/MISSION_CAP_ARRET) : 0;
+		break;
+
+	case ETAPE_CAP:
+		if(fabsf(ecart_angle(cap_cible - theta)) < MISSION_TOLERANCE_CAP){
+			if(++compteur >= MISSION_TICKS_STABLE)
+				etape_suivante();
+		}else{
+			compteur = 0;
+		}
+		break;
+
+	case ETAPE_ATTENTE:
+		if(++compteur >= MS_EN_TICKS((uint16_t)e->a))
+			etape_suivante();
+		break;
+
+	default:
+		etape_suivante();	//type inconnu : etape ignoree
+		break;
+	}
+
+	if(!active)
+		return;			//derniere etape finie : la telecommande reprend la main
+
+	//Le cap est donne par rapport a l'angle estime par l'asservissement : l'ecart mesure par
+	//l'odometrie ne depend pas d'une derive entre les deux reperes
+	CalculPWM_Etat(&angle_controleur, &w);
+	*vitesse = v;
+	*angle = angle_controleur + ecart_angle(cap_cible - theta);
+	*angle -= 2*MISSION_PI*floorf(*angle/(2*MISSION_PI));
+}
+
+/**
+ * @brief  Fonction qui envoie les evenements de la mission quand le canal de telemetrie est libre
+ *         (a appeler a chaque tick)
+ * @param  None
+ * @retval None
+ */
+void mission_rapport_tache(void){
+	odometrie_pose_t pose;
+
+	if(!evenement_en_attente){
+		if(buffer_count(&evenements) < 2)
+			return;
+		buffer_pull(&evenements, &evenement_trame.evenement);
+		buffer_pull(&evenements, &evenement_trame.etape);
+		evenement_trame.nombre = nombre;
+		evenement_trame.reserve = 0;
+		pull_odometrie_pose(&pose);
+		evenement_trame.x = (int16_t)((pose.x > 32767) ? 32767 : ((pose.x < -32767) ? -32767 : pose.x));
+		evenement_trame.y = (int16_t)((pose.y > 32767) ? 32767 : ((pose.y < -32767) ? -32767 : pose.y));
+		evenement_trame.theta = pull_odometrie_theta_mrad();
+		evenement_trame.distance = (active && etapes[etape].type == ETAPE_POINT) ? distance_cm : 0;
+		evenement_en_attente = 1;
+	}
+	if(telemetrie_envoyer(TRAME_MISSION, &evenement_trame, sizeof(evenement_trame)))
+		evenement_en_attente = 0;
+}
+
+/**
+ * @brief  accesseur de l'etat de la mission
+ * @param  None
+ * @retval uint8_t : 1 si une mission est en cours
+ */
+uint8_t pull_mission_active(void){
+	return active;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui passe l'etape en cours dans le repere de l'odometrie
+ * @param  None
+ * @retval None
+ */
+static void preparer_etape(void){
+	const mission_etape_t *e = &etapes[etape];
+	float local_x, local_y, c, s;
+	odometrie_pose_t pose;
+
+	compteur = 0;
+	distance_cm = 0;
+	switch(e->type){
+	case ETAPE_POINT:
+		local_x = e->a*10.0f;
+		local_y = e->b*10.0f;
+		c = cosf(origine_theta);
+		s = sinf(origine_theta);
+		cible_x = origine_x + c*local_x - s*local_y;
+		cible_y = origine_y + s*local_x + c*local_y;
+		pull_odometrie_pose(&pose);
+		cap_cible = atan2f(cible_y - (float)pose.y, cible_x - (float)pose.x);
+		break;
+	case ETAPE_CAP:
+		cap_cible = origine_theta + e->a*0.001f;
+		break;
+	default:
+		cap_cible = (float)pull_odometrie_theta_mrad()*0.001f;	//le cap actuel est tenu
+		break;
+	}
+}
+
+/**
+ * @brief  Fonction qui signale l'etape atteinte et passe a la suivante ou termine la mission
+ * @param  None
+ * @retval None
+ */
+static void etape_suivante(void){
+	signaler(MISSION_ETAPE, etape);
+	if(++etape >= nombre){
+		active = 0;
+		signaler(MISSION_TERMINEE, (uint8_t)(etape - 1));
+		etape = 0;
+	}else{
+		preparer_etape();
+	}
+}
+
+/**
+ * @brief  Fonction qui met un evenement dans la file d'envoi (perdu si la file est pleine)
+ * @param  uint8_t evenement : MISSION_*
+ *         uint8_t numero : etape concernee
+ * @retval None
+ */
+static void signaler(uint8_t evenement, uint8_t numero){
+	if(buffer_count(&evenements) + 2 > buffer_size(&evenements))
+		return;
+	buffer_push(&evenements, evenement);
+	buffer_push(&evenements, numero);
+}
+
+/**
+ * @brief  Fonction qui ramene un ecart d'angle entre -pi et pi
+ * @param  float ecart : ecart (rad)
+ * @retval float : ecart equivalent entre -pi et pi
+ */
+static float ecart_angle(float ecart){
+	return ecart - 2*MISSION_PI*floorf((ecart + MISSION_PI)/(2*MISSION_PI));
+}
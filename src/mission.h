@@ -0,0 +1,104 @@
+/**
+ ******************************************************************************
+ * File Name          : mission.h
+ * Description        : ce module recoit une liste d'etapes par le USART et l'execute
+ * 						sur le robot avec l'odometrie (mode mission)
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+/* Commandes de la telecommande :
+ *   0xF4 | nombre | vitesse | nombre x (type | a | b) | somme   envoi de la mission
+ *   0xF5                                                      depart
+ *   0xF6                                                      abandon
+ * nombre : 1 a MISSION_ETAPES_MAX, vitesse : 0 a 100 (% de la pleine vitesse),
+ * a et b : int16_t en little endian, somme : somme sur 8 bits des octets entre 0xF4 et la somme.
+ * Les points et les caps sont dans le repere du robot au depart de la mission
+ * (x vers l'avant, y vers la gauche, angle positif vers la gauche). */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef MISSION_H_
+#define MISSION_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "telemetrie_trame.h"
+/* Defines -------------------------------------------------------------------*/
+#define MISSION_ETAPES_MAX 		16		//taille de la table des etapes
+#define MISSION_OCTETS_ETAPE 	5		//type, a, b
+
+/* Type d'une etape */
+#define ETAPE_POINT 			0		//aller au point (a, b) en cm
+#define ETAPE_CAP 				1		//tourner sur place jusqu'au cap a (mrad)
+#define ETAPE_ATTENTE 			2		//attendre a ms
+
+#define MISSION_ARRIVEE_MM 		50.0f	//un point est atteint a moins de 5cm
+#define MISSION_FREIN_PAR_MM 	0.0025f	//vitesse maximale par mm restant : ralentit sur les 40 derniers cm
+#define MISSION_VITESSE_MIN 	0.1f	//vitesse minimale d'approche (pleine echelle)
+#define MISSION_CAP_ARRET 		0.6f	//ecart de cap (rad) au-dela duquel le robot tourne sur place
+#define MISSION_TOLERANCE_CAP 	0.05f	//un cap est atteint a moins de 3 degres
+#define MISSION_TICKS_STABLE 	MS_EN_TICKS(100)	//duree pendant laquelle le cap doit etre tenu
+#define MISSION_EVENEMENTS 		4		//evenements en attente d'envoi
+#define MISSION_PI 				3.14159265f
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	int16_t a;				//x (cm), cap (mrad) ou duree (ms)
+	int16_t b;				//y (cm)
+	uint8_t type;			//ETAPE_*
+} mission_etape_t;
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui recoit un octet de la commande 0xF4 (appelee par state_machine)
+ * @param  uint8_t octet : octet recu apres 0xF4
+ * @retval uint8_t : 1 quand la commande est finie (acceptee ou refusee), 0 s'il manque des octets
+ */
+uint8_t mission_recevoir(uint8_t octet);
+
+/**
+ * @brief  Fonction qui prepare la reception d'une mission (commande 0xF4)
+ * @param  None
+ * @retval None
+ */
+void mission_debut_reception(void);
+
+/**
+ * @brief  Fonction qui demarre la mission recue depuis la pose actuelle (commande 0xF5)
+ * @param  None
+ * @retval None
+ */
+void mission_demarrer(void);
+
+/**
+ * @brief  Fonction qui abandonne la mission en cours (commande 0xF6 ou arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void mission_abandonner(void);
+
+/**
+ * @brief  Fonction qui execute la mission : remplace les consignes de la telecommande
+ *         pendant une mission (a appeler a chaque tick de controle)
+ * @param  float *vitesse : consigne de vitesse (-1 a 1), remplacee pendant une mission
+ *         float *angle : consigne d'angle (rad), remplacee pendant une mission
+ * @retval None
+ */
+void mission_tache(float *vitesse, float *angle);
+
+/**
+ * @brief  Fonction qui envoie les evenements de la mission quand le canal de telemetrie est libre
+ *         (a appeler a chaque tick)
+ * @param  None
+ * @retval None
+ */
+void mission_rapport_tache(void);
+
+/**
+ * @brief  accesseur de l'etat de la mission
+ * @param  None
+ * @retval uint8_t : 1 si une mission est en cours
+ */
+uint8_t pull_mission_active(void);
+
+#endif /* MISSION_H_ */
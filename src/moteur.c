@@ -1,29 +1,49 @@
 #include "moteur.h"
 
-void CalculPWM(float Vitesse_D, float Angle_D, float Vg, float Vd, float *Duty_G, float *Duty_D) {
+static ControleurPWM_t Controleur = { GAINS_PWM_DEFAUT, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };	/* Asservissement du robot, utilis par CalculPWM */
+
+void ControleurPWM_Init(ControleurPWM_t *Ctrl, const GainsPWM_t *Gains) {
+	/*
+        Donne les gains  un asservissement et le remet  zro.
+    */
+	Ctrl->Gains = *Gains;
+	ControleurPWM_Reset(Ctrl);
+}
+
+void ControleurPWM_Reset(ControleurPWM_t *Ctrl) {
+	/*
+        Remet l'tat d'un asservissement  zro (robot arrt, angle 0), les gains sont gards.
+    */
+	Ctrl->W = 0.0;
+	Ctrl->Angle = 0.0;
+	Ctrl->ErreurAngle = 0.0;
+	Ctrl->Vt = 0.0;
+	Ctrl->Ut = 0.0;
+	Ctrl->Ua = 0.0;
+}
+
+RAMFUNC void ControleurPWM_Pas(ControleurPWM_t *Ctrl, float Vitesse_D, float Angle_D, float Vg, float Vd, float *Duty_G, float *Duty_D) {
 	/*
         Dans cette fonction, la valeur des duty cycle pour chaque moteur est calcule.
         Ce calcul est effectu  l'aide de la vitesse dsire, de l'angle dsir ainsi
-        qu'avec les vitesses mesures et l'angle actuel.
+        qu'avec les vitesses mesures et l'angle actuel. Tout l'tat est dans Ctrl.
     */
-	static float Old_W = 0.0, W = 0.0;
-	static float ErreurAngle = 0.0, Angle = 0.0;
-	static float Vt = 0.0, Ut = 0.0, Ua = 0.0;
-	static int   Signe_Ua = 0, Signe_Ut = 0;
+	float Old_W, W, Angle, ErreurAngle, Vt, Ut, Ua;
+	int   Signe_Ua = 0, Signe_Ut = 0;
 
     Vg = (Vg > 1.0) ? 1.0 : ((Vg < -1.0) ? -1.0 : Vg);  /* Regarde les limites (-1.0  1.0) */
     Vd = (Vd > 1.0) ? 1.0 : ((Vd < -1.0) ? -1.0 : Vd);  /* Regarde les limites (-1.0  1.0) */
 
-    Old_W = W;
+    Old_W = Ctrl->W;
     W     = 0.5*(Vmax/RAYON)*(Vd - Vg);
     Vt    = 0.5*(Vd + Vg);
 
-    Angle = Angle + (0.5)*TS*(W + Old_W);
+    Angle = Ctrl->Angle + (0.5)*TS*(W + Old_W);
     Angle = (Angle > 2.0*Pi) ? (Angle - 2*Pi) : ((Angle < 0.0) ? (Angle + 2*Pi) : Angle); /* Angle entre 0 et 2 pi */
     ErreurAngle = ((Angle_D >= Pi + Angle) ? (Angle_D - 2*Pi) : ((Angle_D <= -Pi + Angle) ? (Angle_D + 2*Pi) : Angle_D)) - Angle;
 
-    Ut = -H11*Vt + H12*Vitesse_D;
-    Ua = H21*ErreurAngle - H22*W;
+    Ut = -Ctrl->Gains.h11*Vt + Ctrl->Gains.h12*Vitesse_D;
+    Ua = Ctrl->Gains.h21*ErreurAngle - Ctrl->Gains.h22*W;
 
     Signe_Ut = (Ut >= 0.0) ? 1 : -1;
     Signe_Ua = (Ua >= 0.0) ? 1 : -1;
@@ -37,4 +57,33 @@ void CalculPWM(float Vitesse_D, float Angle_D, float Vg, float Vd, float *Duty_G
 
     *Duty_D = (*Duty_D > 0.99) ? 0.99 : ((*Duty_D < -0.99) ? -0.99 : *Duty_D);
     *Duty_G = (*Duty_G > 0.99) ? 0.99 : ((*Duty_G < -0.99) ? -0.99 : *Duty_G);
+
+    Ctrl->W           = W;
+    Ctrl->Angle       = Angle;
+    Ctrl->ErreurAngle = ErreurAngle;
+    Ctrl->Vt          = Vt;
+    Ctrl->Ut          = Ut;
+    Ctrl->Ua          = Ua;
+}
+
+RAMFUNC void CalculPWM(float Vitesse_D, float Angle_D, float Vg, float Vd, float *Duty_G, float *Duty_D) {
+	/*
+        Calcule les duty cycle avec l'asservissement du robot.
+    */
+	ControleurPWM_Pas(&Controleur, Vitesse_D, Angle_D, Vg, Vd, Duty_G, Duty_D);
+}
+
+void CalculPWM_Etat(float *Angle_E, float *W_E) {
+	/*
+        Donne l'angle et la vitesse angulaire estimes par CalculPWM au dernier appel.
+    */
+	*Angle_E = Controleur.Angle;
+	*W_E     = Controleur.W;
+}
+
+ControleurPWM_t *CalculPWM_Controleur(void) {
+	/*
+        Donne l'asservissement du robot, pour le lire, le copier ou changer ses gains.
+    */
+	return &Controleur;
 }
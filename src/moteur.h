@@ -7,9 +7,11 @@
 #ifndef __MOTOR_H_
 #define __MOTOR_H_
 
+#include "carte.h"
+
 #define Pi      (3.1415926535897932)
 #define RAYON   (9.525)
-#define TS      (0.005)
+#define TS      (CONTROLE_PERIODE_MS/1000.0)
 #define Vmax    (88.88)
 #define Tau     (0.5)
 
@@ -19,6 +21,30 @@
 #define H21     (1.1613504)
 #define H22     (0.5806746734)
 
-void CalculPWM(float Vitesse_D, float Angle_D, float Vg, float Vd, float *Duty_G, float *Duty_D);
+/* Gains de l'asservissement, H11 a H22 par dfaut */
+typedef struct {
+	float h11, h12;		/* Vitesse de translation */
+	float h21, h22;		/* Angle */
+} GainsPWM_t;
+
+/* tat d'un asservissement : plusieurs instances peuvent tourner en mme temps (outils/simulation) */
+typedef struct {
+	GainsPWM_t Gains;
+	float W;			/* Vitesse angulaire estime */
+	float Angle;		/* Angle estim (0  2 pi) */
+	float ErreurAngle;	/* Dernire erreur d'angle */
+	float Vt;			/* Dernire vitesse de translation mesure */
+	float Ut, Ua;		/* Dernires commandes de translation et de rotation */
+} ControleurPWM_t;
+
+#define GAINS_PWM_DEFAUT	{ H11, H12, H21, H22 }
+
+void ControleurPWM_Init(ControleurPWM_t *Ctrl, const GainsPWM_t *Gains);
+void ControleurPWM_Reset(ControleurPWM_t *Ctrl);
+RAMFUNC void ControleurPWM_Pas(ControleurPWM_t *Ctrl, float Vitesse_D, float Angle_D, float Vg, float Vd, float *Duty_G, float *Duty_D);
+
+RAMFUNC void CalculPWM(float Vitesse_D, float Angle_D, float Vg, float Vd, float *Duty_G, float *Duty_D);
+void CalculPWM_Etat(float *Angle_E, float *W_E);
+ControleurPWM_t *CalculPWM_Controleur(void);
 
 #endif
@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ * File Name          : odometrie.h
+ * Description        : ce module integre les vitesses des roues en une pose (x, y, theta)
+ * 						a chaque tick de controle (navigation a l'estime)
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+/* Ce module n'utilise que des entiers et ne depend d'aucun header du microcontroleur */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef ODOMETRIE_H_
+#define ODOMETRIE_H_
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "carte.h"
+#include "moteur.h"
+/* Defines -------------------------------------------------------------------*/
+#define ODOMETRIE_VMAX_MM_S 	((float)(Vmax*10))			//vitesse d'une roue a pleine echelle (Vmax est en cm/s)
+#define ODOMETRIE_DEMI_VOIE_MM 	(RAYON*10)					//demi-distance entre les roues (RAYON est en cm)
+#define ODOMETRIE_PERIODE_S 	(CONTROLE_PERIODE_MS/1000.0)	//periode du tick de controle
+
+/* Angle binaire : un tour complet vaut 2^32, le depassement de l'entier fait le modulo 2 pi */
+#define ODOMETRIE_PI 			0x80000000UL
+
+/* Position interne en 1/2^24 mm, angle interne avec 16 bits de fraction */
+#define ODOMETRIE_Q_POSITION 	24
+#define ODOMETRIE_Q_ANGLE 		16
+
+/* Trapeze sur deux ticks : ds = T/4 * (vg + vd + vg' + vd'), dtheta = T/(4*demi-voie) * (vd - vg + vd' - vg') */
+#define ODOMETRIE_K_DISTANCE 	((int64_t)(ODOMETRIE_PERIODE_S/4.0*(1UL << ODOMETRIE_Q_POSITION) + 0.5))
+#define ODOMETRIE_K_ANGLE 		((int64_t)(ODOMETRIE_PERIODE_S/(4.0*ODOMETRIE_DEMI_VOIE_MM) \
+									*(4294967296.0/6.283185307179586)*(1UL << ODOMETRIE_Q_ANGLE) + 0.5))
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	int32_t x;			//position selon l'axe de depart (mm)
+	int32_t y;			//position a gauche de l'axe de depart (mm)
+	uint32_t theta;		//cap, angle binaire (2^32 = 2 pi), positif vers la gauche
+} odometrie_pose_t;
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui remet la pose a l'origine (x = y = 0, theta = 0)
+ * @param  None
+ * @retval None
+ */
+void odometrie_reset(void);
+
+/**
+ * @brief  Fonction qui oublie les vitesses du tick precedent quand les roues sont arretees
+ *         (arret d'urgence), la pose est conservee
+ * @param  None
+ * @retval None
+ */
+void odometrie_arret(void);
+
+/**
+ * @brief  Fonction qui integre les vitesses des roues dans la pose (a appeler a chaque tick)
+ * @param  int16_t v_gauche : vitesse de la roue gauche (mm/s)
+ *         int16_t v_droite : vitesse de la roue droite (mm/s)
+ * @retval None
+ */
+void odometrie_tache(int16_t v_gauche, int16_t v_droite);
+
+/**
+ * @brief  accesseur de la pose
+ * @param  odometrie_pose_t *pose : pose estimee
+ * @retval None
+ */
+void pull_odometrie_pose(odometrie_pose_t *pose);
+
+/**
+ * @brief  accesseur du cap en mrad
+ * @param  None
+ * @retval int16_t : cap (mrad, -pi a pi)
+ */
+int16_t pull_odometrie_theta_mrad(void);
+
+/**
+ * @brief  Fonction qui calcule le sinus et le cosinus d'un angle binaire (table d'un quart de
+ *         tour et interpolation lineaire)
+ * @param  uint32_t angle : angle binaire (2^32 = 2 pi)
+ *         int32_t *sin_angle : sinus (1/32768)
+ *         int32_t *cos_angle : cosinus (1/32768)
+ * @retval None
+ */
+void odometrie_sin_cos(uint32_t angle, int32_t *sin_angle, int32_t *cos_angle);
+
+#endif /* ODOMETRIE_H_ */
@@ -0,0 +1,86 @@
+/**
+ * @file        pile.c
+ * @brief       Stack high-water mark and RAM usage.
+ *
+ * @details     Before main() runs, the startup code fills the RAM between
+ * the end of the static data (_end) and the stack pointer with PILE_MOTIF.
+ * The stack grows down from _estack, so the lowest word that no longer
+ * holds the pattern gives the deepest stack use since reset. The scan
+ * starts from the bottom and stops at the first overwritten word. If the
+ * heap were used, it would be counted as stack, which makes the result
+ * conservative.
+ *
+ * The result is sent as a TRAME_PILE frame when the remote asks for it
+ * (command 0xF3). The static part of the budget per module comes from the
+ * map file, through tools/ram_rapport.py.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "pile.h"
+#include "telemetrie.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define PILE_RAM_DEBUT 	0x20000000UL
+
+/* Private variables ---------------------------------------------------------*/
+extern uint32_t _end;		//fin des donnees statiques (linker script)
+extern uint32_t _estack;	//haut de la pile (linker script)
+
+static uint8_t rapport_demande = 0;
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui mesure l'occupation de la RAM et le niveau maximal de la pile
+ * @param  trame_pile_t *mesure : resultat de la mesure (octets)
+ * @retval None
+ */
+void pile_mesure(trame_pile_t *mesure){
+	uint32_t debut = (uint32_t)(uintptr_t)&_end;
+	uint32_t fin = (uint32_t)(uintptr_t)&_estack;
+	uint32_t sp = __get_MSP();
+	uint32_t adresse = debut;
+	uint16_t statique, pile_max, pile_libre, pile_actuelle;
+
+	while(adresse < sp && *(volatile uint32_t *)(uintptr_t)adresse == PILE_MOTIF)
+		adresse += 4;
+
+	statique = (uint16_t)(debut - PILE_RAM_DEBUT);
+	pile_libre = (uint16_t)(adresse - debut);
+	pile_max = (uint16_t)(fin - adresse);
+	pile_actuelle = (uint16_t)(fin - sp);
+
+	mesure->statique = statique;
+	mesure->pile_max = pile_max;
+	mesure->pile_libre = pile_libre;
+	mesure->pile_actuelle = pile_actuelle;
+}
+
+/**
+ * @brief  Fonction qui demande l'envoi de la mesure de la pile sur le USART (commande 0xF3)
+ * @param  None
+ * @retval None
+ */
+void pile_demande_rapport(void){
+	rapport_demande = 1;
+}
+
+/**
+ * @brief  Fonction qui envoie la mesure demandee quand le canal de telemetrie est libre
+ *         (a appeler a chaque tick)
+ * @param  None
+ * @retval None
+ */
+void pile_tache(void){
+	trame_pile_t mesure;
+
+	if(!rapport_demande)
+		return;
+
+	pile_mesure(&mesure);
+	if(telemetrie_envoyer(TRAME_PILE, &mesure, sizeof(mesure)))
+		rapport_demande = 0;
+}
@@ -0,0 +1,44 @@
+/**
+ ******************************************************************************
+ * File Name          : pile.h
+ * Description        : ce module mesure le niveau maximal atteint par la pile
+ * 						(la RAM libre est peinte au demarrage par startup_stm32f0xx.s)
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef PILE_H_
+#define PILE_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "telemetrie_trame.h"
+/* Defines -------------------------------------------------------------------*/
+#define PILE_MOTIF 		0xA5C3A5C3UL	//doit etre le meme que dans startup_stm32f0xx.s
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui mesure l'occupation de la RAM et le niveau maximal de la pile
+ * @param  trame_pile_t *mesure : resultat de la mesure (octets)
+ * @retval None
+ */
+void pile_mesure(trame_pile_t *mesure);
+
+/**
+ * @brief  Fonction qui demande l'envoi de la mesure de la pile sur le USART (commande 0xF3)
+ * @param  None
+ * @retval None
+ */
+void pile_demande_rapport(void);
+
+/**
+ * @brief  Fonction qui envoie la mesure demandee quand le canal de telemetrie est libre
+ *         (a appeler a chaque tick)
+ * @param  None
+ * @retval None
+ */
+void pile_tache(void);
+
+#endif /* PILE_H_ */
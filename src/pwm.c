@@ -5,8 +5,9 @@
  * @details     This module contains the functions to configure and manage the
  * TIM3 peripheral for PWM generation. It controls the speed and direction of
  * the robot's motors by adjusting the PWM duty cycle and setting GPIO pins
- * for forward/reverse control. An interrupt handler is also included to
- * signal a 5ms interval for other tasks within the system.
+ * for forward/reverse control. The update interrupt is only enabled while
+ * a direction change waits for the next PWM period; the control tick comes
+ * from the SysTick, so the PWM frequency can be set independently.
  *
  * @author      Thomas Giguere Sturrock
  * @date        Jun 2022
@@ -14,10 +15,19 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "pwm.h"
-#include <math.h>
+#include "horloge.h"
 /* Defines -------------------------------------------------------------------*/
-#define TIM3_PRESCALER (4 - 1)
-#define TIM3_ARR_VALUE (60000-1)
+/* Le plus petit diviseur qui garde ARR sur 16 bits pour PWM_FREQUENCE_HZ */
+#define TIM3_PRESCALER(hz) ((hz)/(PWM_FREQUENCE_HZ*65536UL))
+#define TIM3_ARR_VALUE(hz) ((hz)/((TIM3_PRESCALER(hz)+1)*PWM_FREQUENCE_HZ) - 1)
+
+/* Private variables ---------------------------------------------------------*/
+static volatile uint32_t direction_attente = 0;	//mot BSRR du sens a appliquer a l'update
+static volatile uint8_t verrou_arret = 0;		//1 apres arret_moteur jusqu'a liberer_moteur
+static volatile uint32_t periode = TIM3_ARR_VALUE(HCLK_HZ);	//ARR de TIM3 a la frequence actuelle
+
+/* Private function prototypes -----------------------------------------------*/
+static inline uint32_t direction_bsrr(uint8_t pin, int16_t duty, uint8_t frein);
 
 /* Public functions  ---------------------------------------------------------*/
 
@@ -28,11 +38,11 @@
  */
 void init_pwm(){
 
-	GPIO_MODE_CONFIG(GPIOB, 4, GPIO_ALT_FUNC);
-	GPIO_MODE_CONFIG(GPIOB, 5, GPIO_ALT_FUNC);
+	BROCHE_MODE(PWM_GAUCHE, GPIO_ALT_FUNC);
+	BROCHE_MODE(PWM_DROITE, GPIO_ALT_FUNC);
 
-	GPIO_ALTFUN_CONFIG(GPIOB, 4, 1);
-	GPIO_ALTFUN_CONFIG(GPIOB, 5, 1);
+	GPIO_ALTFUN_CONFIG(BROCHE_GPIO(PWM_GAUCHE), PWM_GAUCHE_PIN, PWM_AF);
+	GPIO_ALTFUN_CONFIG(BROCHE_GPIO(PWM_DROITE), PWM_DROITE_PIN, PWM_AF);
 
 	RCC->APB1ENR |= (uint16_t)RCC_APB1ENR_TIM3EN;
 
@@ -42,26 +52,24 @@ void init_pwm(){
 	TIM3->CCER |= (uint16_t)(TIM_CCER_CC1P|TIM_CCER_CC2P);
 	TIM3->CCER |= (uint16_t)(TIM_CCER_CC1E|TIM_CCER_CC2E);
 	TIM3->CR1 &= (uint16_t)~(TIM_CR1_CMS|TIM_CR1_DIR);
+	TIM3->CR1 |= (uint16_t)TIM_CR1_URS; /* Seul le debordement genere l'interruption, pas le UG de arret_moteur */
 	TIM3->CR1 |= (uint16_t)TIM_CR1_CEN;
 	TIM3->EGR |= (uint16_t)TIM_EGR_UG;
 
-	TIM3->PSC = (uint16_t)TIM3_PRESCALER; /* Diviseur d'horloge */
-	TIM3->ARR = (uint16_t)TIM3_ARR_VALUE; /* Compte maximal pour compléter un cycle */
 	TIM3->CCR1 = (uint16_t)0;
 	TIM3->CCR2 = (uint16_t)0;
+	pwm_horloge(pull_horloge_hz()); /* Diviseur d'horloge et compte maximal pour compléter un cycle */
 
-	TIM3->DIER |= (uint16_t)TIM_DIER_UIE;
-
-	NVIC->ISER[0] |= 1<<TIM3_IRQn;
-	NVIC->IP[(uint32_t)(TIM3_IRQn>>2)] = THE_ANWSER<<(((TIM3_IRQn & 0x03) << 3)*8) ;
+	NVIC_SetPriority(TIM3_IRQn, PRIORITE_PWM);
+	NVIC_EnableIRQ(TIM3_IRQn);
 
 	/*
 	 * init direction
 	 */
-	GPIO_MODE_CONFIG(GPIOB,12,1);
-	GPIO_MODE_CONFIG(GPIOB,13,1);
-	GPIO_MODE_CONFIG(GPIOB,14,1);
-	GPIO_MODE_CONFIG(GPIOB,15,1);
+	GPIO_MODE_CONFIG(BROCHE_GPIO(DIRECTION), DIRECTION_GAUCHE_PIN, GPIO_OUTPUT);
+	GPIO_MODE_CONFIG(BROCHE_GPIO(DIRECTION), DIRECTION_GAUCHE_PIN+1, GPIO_OUTPUT);
+	GPIO_MODE_CONFIG(BROCHE_GPIO(DIRECTION), DIRECTION_DROITE_PIN, GPIO_OUTPUT);
+	GPIO_MODE_CONFIG(BROCHE_GPIO(DIRECTION), DIRECTION_DROITE_PIN+1, GPIO_OUTPUT);
 }
 
 /**
@@ -76,51 +84,130 @@ void update_moteur(float vitesse_gauche, float vitesse_droite,uint8_t arret_urge
 	 * verifie si il y a une arret d'urgence
 	 */
 	if(arret_urgence){
-		SET_GPIO(GPIOB,12);
-		SET_GPIO(GPIOB,13);
+		arret_moteur();
+	}
+	else{
+		update_moteur_entier((int16_t)(vitesse_gauche*DUTY_PLEINE_ECHELLE),
+				(int16_t)(vitesse_droite*DUTY_PLEINE_ECHELLE), 0);
+	}
+
+}
+
+/**
+ * @brief  Fonction qui applique un duty entier et le sens a chaque moteur
+ * @param  int16_t duty_gauche : duty signe du moteur gauche (+/- DUTY_PLEINE_ECHELLE)
+ *         int16_t duty_droite : duty signe du moteur droit (+/- DUTY_PLEINE_ECHELLE)
+ *         uint8_t frein : FREIN_GAUCHE et/ou FREIN_DROIT pour court-circuiter le moteur
+ * @retval None
+ */
+void update_moteur_entier(int16_t duty_gauche, int16_t duty_droite, uint8_t frein){
+	uint32_t direction;
+
+	if(frein & FREIN_GAUCHE)
+		duty_gauche = 0;
+	if(frein & FREIN_DROIT)
+		duty_droite = 0;
 
-		SET_GPIO(GPIOB,14);
-		SET_GPIO(GPIOB,15);
+	/*
+	 * le sens des deux moteurs est mis dans un seul mot BSRR, ecrit par
+	 * TIM3_IRQHandler a l'evenement d'update en meme temps que le chargement des CCR
+	 */
+	direction = direction_bsrr(DIRECTION_GAUCHE_PIN, duty_gauche, frein & FREIN_GAUCHE)
+			| direction_bsrr(DIRECTION_DROITE_PIN, duty_droite, frein & FREIN_DROIT);
+
+	uint32_t duty_abs1 = (uint32_t)abs(duty_gauche);
+	uint32_t duty_abs2 = (uint32_t)abs(duty_droite);
+
+	/*
+	 * UDIS empeche l'update entre les deux ecritures : les CCR preload et le sens
+	 * sont pris en compte ensemble au debut de la meme periode de PWM
+	 */
+	TIM3->CR1 |= (uint16_t)TIM_CR1_UDIS;
+	TIM3->CCR1 = (periode*duty_abs1)/DUTY_PLEINE_ECHELLE;
+	TIM3->CCR2 = (periode*duty_abs2)/DUTY_PLEINE_ECHELLE;
+	direction_attente = direction;
+	TIM3->SR = ~((uint16_t) TIM_SR_UIF);
+	TIM3->DIER |= (uint16_t)TIM_DIER_UIE;
+	TIM3->CR1 &= (uint16_t)~TIM_CR1_UDIS;
+
+	//un arret d'urgence survenu pendant la mise a jour l'emporte
+	if(verrou_arret){
+		arret_moteur();
+	}
+}
+
+/**
+ * @brief  Fonction qui coupe les moteurs immediatement (freinage et duty a 0)
+ *         Peut etre appelee depuis une interruption
+ * @param  None
+ * @retval None
+ */
+void arret_moteur(void){
+	verrou_arret = 1;
+	direction_attente = 0;
+	BROCHE_GPIO(DIRECTION)->BSRR = direction_bsrr(DIRECTION_GAUCHE_PIN, 0, 1) | direction_bsrr(DIRECTION_DROITE_PIN, 0, 1);
 
+	/*
+	 * les CCR sont en preload, on force un UG pour que le 0 soit applique
+	 * tout de suite plutot qu'a la fin de la periode de PWM
+	 */
+	TIM3->DIER &= (uint16_t)~TIM_DIER_UIE;
+	if(TIM3->CCR1 || TIM3->CCR2){
 		TIM3->CCR1 = (uint32_t)0;
 		TIM3->CCR2 = (uint32_t)0;
+		TIM3->EGR = (uint16_t)TIM_EGR_UG;
 	}
-	else{
-		/*
-		 * regarde le sens voulu du moteur droit
-		 */
-		if(vitesse_droite<0){
-			RESET_GPIO(GPIOB,14);
-			SET_GPIO(GPIOB,15);
-		}else if(vitesse_droite>0){
-			SET_GPIO(GPIOB,14);
-			RESET_GPIO(GPIOB,15);
-		}else{
-			RESET_GPIO(GPIOB,14);
-			RESET_GPIO(GPIOB,15);
-		}
+}
 
-		/*
-		 * regarde le sens voulu du moteur gauche
-		 */
-		if(vitesse_gauche<0){
-
-			RESET_GPIO(GPIOB,12);
-			SET_GPIO(GPIOB,13);
-		}else if(vitesse_gauche>0){
-			SET_GPIO(GPIOB,12);
-			RESET_GPIO(GPIOB,13);
-		}else{
-			RESET_GPIO(GPIOB,12);
-			RESET_GPIO(GPIOB,13);
-		}
-
-		float speed_abs1 = fabs(vitesse_gauche);
-		float speed_abs2 = fabs(vitesse_droite);
-		TIM3->CCR1 = (uint32_t)((float)(TIM3_ARR_VALUE)*speed_abs1);
-		TIM3->CCR2 = (uint32_t)((float)(TIM3_ARR_VALUE)*speed_abs2);
-	}
+/**
+ * @brief  Fonction qui recalcule le diviseur et la periode de TIM3 apres un changement
+ *         d'horloge, en gardant les duty appliques
+ * @param  uint32_t hz : frequence de PCLK
+ * @retval None
+ */
+void pwm_horloge(uint32_t hz){
+	uint32_t ancienne = periode;
+	uint32_t nouvelle = TIM3_ARR_VALUE(hz);
+
+	TIM3->CR1 |= (uint16_t)TIM_CR1_UDIS;
+	TIM3->PSC = (uint16_t)TIM3_PRESCALER(hz);
+	TIM3->ARR = (uint16_t)nouvelle;
+	TIM3->CCR1 = (TIM3->CCR1*nouvelle)/ancienne;
+	TIM3->CCR2 = (TIM3->CCR2*nouvelle)/ancienne;
+	periode = nouvelle;
+	TIM3->CR1 &= (uint16_t)~TIM_CR1_UDIS;
+
+	//PSC et CCR preload pris en compte tout de suite, sauf si un sens attend l'update
+	if(!direction_attente)
+		TIM3->EGR = (uint16_t)TIM_EGR_UG;
+}
 
+/**
+ * @brief  Fonction qui permet de nouveau de commander les moteurs apres arret_moteur
+ * @param  None
+ * @retval None
+ */
+void liberer_moteur(void){
+	verrou_arret = 0;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui donne le mot BSRR du sens d'un moteur
+ * @param  uint8_t pin : premiere des deux broches de sens du moteur (LSB)
+ *         int16_t duty : duty signe du moteur
+ *         uint8_t frein : different de 0 pour court-circuiter le moteur (11)
+ * @retval uint32_t : bits de set (0-15) et de reset (16-31) des deux broches
+ */
+static inline uint32_t direction_bsrr(uint8_t pin, int16_t duty, uint8_t frein){
+	if(frein)
+		return (1UL<<pin)|(1UL<<(pin+1));				//11
+	if(duty<0)
+		return (1UL<<(pin+16))|(1UL<<(pin+1));			//10 (MSB)
+	if(duty>0)
+		return (1UL<<pin)|(1UL<<(pin+1+16));			//01 (LSB)
+	return (1UL<<(pin+16))|(1UL<<(pin+1+16));			//00
 }
 
 
@@ -130,12 +217,24 @@ void update_moteur(float vitesse_gauche, float vitesse_droite,uint8_t arret_urge
  * @retval None
  */
 void TIM3_IRQHandler(void) {
+	uint32_t primask, direction;
+
 	if ((TIM3->SR & TIM_SR_UIF) != 0) { // Vérifie qu’il s’agit d’une fin de cycle du PWM
 		TIM3->SR = ~((uint16_t) TIM_SR_UIF); // Remet le drapeau d’interruption à zéro
+		/*
+		 * lecture, effacement et ecriture du sens sans interruption : un arret_moteur
+		 * appele par une interruption plus prioritaire ne peut pas etre ecrase par
+		 * un sens lu avant lui
+		 */
+		primask = __get_PRIMASK();
+		__set_PRIMASK(1);
+		direction = direction_attente;
+		direction_attente = 0;
+		if(direction && !verrou_arret)
+			BROCHE_GPIO(DIRECTION)->BSRR = direction; // Sens des deux moteurs en une ecriture, avec les CCR
+		__set_PRIMASK(primask);
+		TIM3->DIER &= (uint16_t)~TIM_DIER_UIE; // Rien d'autre a faire avant le prochain changement
 	}
-	interup_5ms = 1;//met flag d'interup a 1 pour indiquer que 5ms c'est passer
-	adc_5ms = 1;
-	counterDelay5ms++;
 
 }
 
@@ -12,6 +12,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 /* Defines -------------------------------------------------------------------*/
+#define DUTY_PLEINE_ECHELLE 10000	//duty de 100% en representation entiere (1/10000)
+#define FREIN_GAUCHE 		0x01
+#define FREIN_DROIT 		0x02
 
 /* Type definitions ----------------------------------------------------------*/
 
@@ -30,5 +33,37 @@ void init_pwm();
  */
 void update_moteur(float vitesse_gauche, float vitesse_droite,uint8_t arret_urgence);
 
+/**
+ * @brief  Fonction qui applique un duty entier et le sens a chaque moteur
+ * @param  int16_t duty_gauche : duty signe du moteur gauche (+/- DUTY_PLEINE_ECHELLE)
+ *         int16_t duty_droite : duty signe du moteur droit (+/- DUTY_PLEINE_ECHELLE)
+ *         uint8_t frein : FREIN_GAUCHE et/ou FREIN_DROIT pour court-circuiter le moteur
+ * @retval None
+ */
+void update_moteur_entier(int16_t duty_gauche, int16_t duty_droite, uint8_t frein);
+
+/**
+ * @brief  Fonction qui coupe les moteurs immediatement (freinage et duty a 0)
+ *         Peut etre appelee depuis une interruption
+ * @param  None
+ * @retval None
+ */
+void arret_moteur(void);
+
+/**
+ * @brief  Fonction qui recalcule le diviseur et la periode de TIM3 apres un changement
+ *         d'horloge, en gardant les duty appliques
+ * @param  uint32_t hz : frequence de PCLK
+ * @retval None
+ */
+void pwm_horloge(uint32_t hz);
+
+/**
+ * @brief  Fonction qui permet de nouveau de commander les moteurs apres arret_moteur
+ * @param  None
+ * @retval None
+ */
+void liberer_moteur(void);
+
 
 #endif /* PWM_H_ */
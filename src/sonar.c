@@ -5,10 +5,24 @@
  * @details     This module provides the core logic for the robot's sonar-based
  * obstacle detection. It manages communication with the left and right sonar
  * sensors via the I2C bus, initiating pings and reading the distance to the
- * nearest object. The detection range is dynamically adjusted based on the
- * robot's current speed. It also provides status flags to indicate if an
+ * nearest object. It also provides status flags to indicate if an
  * obstacle has been detected on either side.
  *
+ * The pings are scheduled without busy waiting. The SRF10 range register
+ * is set from the commanded speed: a margin plus a stopping distance that
+ * grows with the square of the speed. The echo window of a ping lasts
+ * for the time of flight at that range plus a guard time for late echoes.
+ * At the end of the window the sensor is read, and the other sensor
+ * pings only after that read, so the two echo windows never overlap.
+ * When the robot is slow or stopped, each window gets an extra wait of up
+ * to SONAR_ATTENTE_MS, so there are fewer pings. At full speed the sides
+ * alternate as fast as the range allows.
+ *
+ * Each reading goes through a per-sensor filter (filtre_sonar.c): median,
+ * a gate on impossible jumps, closing speed and time to collision. A side
+ * is flagged when its time to collision is below SONAR_TTC_MS, or when the
+ * object is closer than SONAR_DISTANCE_MIN_CM.
+ *
  * @author      Thomas Giguere Sturrock
  * @date        Jun 2022
  */
@@ -16,100 +30,239 @@
 /* Includes ------------------------------------------------------------------*/
 #include "sonar.h"
 #include "i2c.h"
+#include "chien.h"
+#include "filtre_sonar.h"
+#include "trajectoire.h"
 #include <math.h>
 
 /* Private variables ---------------------------------------------------------*/
-uint8_t swap_gauche_droite = 0;
-uint8_t compteur_nb_5ms = 0;
+static uint8_t capteur = SONAR_DROIT;		//sonar dont la fenetre d'echo est en cours
+static uint8_t ticks_restants = 0;			//ticks avant la fin de la fenetre d'echo
+static uint8_t ping_fait = 0;				//1 des que le sonar courant a pinge
+static uint8_t lecture_en_attente = 0;		//1 si une lecture est dans le tampon du I2C
+static uint8_t capteur_lu = SONAR_GAUCHE;	//sonar de la lecture en attente
+static volatile uint8_t lecture = 0;		//ecrit par I2C1_IRQHandler (jamais sur la pile)
+static uint8_t periode_ms = 0;				//duree de la derniere fenetre d'echo
 
-uint8_t sonar_gauche = 100;
+uint8_t sonar_gauche = 100;				//distance filtree (cm)
 uint8_t sonar_droit = 100;
 
+static filtre_sonar_t filtre[2];
+static uint16_t ecoule_ms[2] = {0, 0};		//temps depuis la derniere lecture de chaque sonar
+
+static uint8_t etat_gauche = 0;
+static uint8_t etat_droit = 0;
+
 uint8_t init_sonar = 1;
 
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t portee_registre(float vitesse);
+static uint8_t fenetre_ticks(uint8_t portee, float vitesse);
+static void evaluer_obstacles(void);
+
 /* Public functions  ---------------------------------------------------------*/
 
 /**
- * @brief  Fonction qui renvoie le sonar qui a un objet le plus proche
- * @param  control_struct_t *control : structure de controle pour avoir la vitesse du robot
- * 		   uint8_t *etatDroit : etat du sonar droit (1=obstacle a droite, 0= pas d'obstacle a droite)
+ * @brief  Fonction qui ordonnance les pings des sonars sans attente active et renvoie le sonar
+ *         qui a un objet le plus proche (a appeler a chaque tick de controle). La portee suit
+ *         la vitesse du profil (trajectoire.c)
+ * @param  uint8_t *etatDroit : etat du sonar droit (1=obstacle a droite, 0= pas d'obstacle a droite)
  * 		   uint8_t *etatGauche : etat du sonar gauche (1=obstacle a gauche, 0= pas d'obstacle a gauche)
  * @retval None
  */
-void task_sonar(control_struct_t *control,uint8_t *etatDroit,uint8_t *etatGauche){
+void task_sonar(uint8_t *etatDroit,uint8_t *etatGauche){
+	float vitesse, angle;
+	uint8_t portee;
+
+	//Vitesse reellement commandee (profil de la telecommande, de la mission ou de la rampe
+	//de perte de liaison) au tick precedent, et non la consigne brute de la telecommande
+	pull_trajectoire(&vitesse,&angle);
 
 	/*
 	 * initialise le sonar
 	 */
 	if(init_sonar){
-		I2C_Write(SONAR_ADR_G, SRF10_MAX_GAIN, 10); //j'ai un bug que le premier write de i2c du programe fonctionne pas
-
-		I2C_Write(SONAR_ADR_G, SRF10_MAX_GAIN, 10); // set le gain de gauche a 10
-		I2C_Write(SONAR_ADR_D, SRF10_MAX_GAIN, 10); // set le gain de droit a 10
+		filtre_sonar_init(&filtre[SONAR_GAUCHE]);
+		filtre_sonar_init(&filtre[SONAR_DROIT]);
+		I2C_Write(SONAR_ADR_G, SRF10_MAX_GAIN, SONAR_GAIN); // set le gain de gauche
+		I2C_Write(SONAR_ADR_D, SRF10_MAX_GAIN, SONAR_GAIN); // set le gain de droit
 		init_sonar=0;
 	}
 
-	if(compteur_nb_5ms>=10){//permet de s'enclancher seulement tout les 50ms
-
-		uint8_t lsb =0;
-		float vitesse = (pullVitesse(control));
-
-		uint8_t range_sonar = (uint8_t)(MINRANGE+(float)(DELTA_RANGE*fabs(vitesse)));//donne une valeur entre MINRANGE et MAXRANGE
+	/*
+	 * un changement d'horloge a jete les trames du I2C : la lecture et le ping en cours
+	 * sont perdus, on recommence une fenetre d'echo
+	 */
+	if(i2c_purge()){
+		lecture_en_attente = 0;
+		ping_fait = 0;
+		ticks_restants = 0;
+	}
 
-		uint8_t range_activation =(uint8_t)(100 + abs(vitesse*100));//varie la detection entre 1 et 2m selon la vitesse
+	/*
+	 * la lecture est faite apres la fin de la fenetre d'echo, elle est terminee
+	 * quand le tampon du I2C est vide
+	 */
+	for(uint8_t i=SONAR_GAUCHE;i<=SONAR_DROIT;i++){
+		if(ecoule_ms[i] < 0xFFFF - CONTROLE_PERIODE_MS)
+			ecoule_ms[i] += CONTROLE_PERIODE_MS;
+	}
 
+	if(lecture_en_attente && i2c_termine()){
+		//Le SRF10 renvoie 0 quand aucun echo n'est recu dans la portee
+		filtre_sonar_ajouter(&filtre[capteur_lu], lecture ? lecture : SONAR_HORS_PORTEE_CM, ecoule_ms[capteur_lu]);
+		ecoule_ms[capteur_lu] = 0;
+		sonar_gauche = pull_filtre_distance(&filtre[SONAR_GAUCHE]);
+		sonar_droit = pull_filtre_distance(&filtre[SONAR_DROIT]);
+		lecture_en_attente = 0;
+		evaluer_obstacles();
+		chien_signaler(CHIEN_SONAR);// une mesure complete
+	}
 
+	if(ticks_restants == 0){
+		/*
+		 * fin de la fenetre du sonar courant : on le lit, puis on fait pinger l'autre.
+		 * Les trames sont traitees dans l'ordre, le ping suivant part donc apres la lecture
+		 * et les fenetres d'echo des deux sonars ne se chevauchent jamais
+		 */
+		if(ping_fait && !lecture_en_attente){
+			capteur_lu = capteur;
+			lecture_en_attente = 1;
+			I2C_Read(capteur == SONAR_GAUCHE ? SONAR_ADR_G : SONAR_ADR_D, SRF10_RANGE_LSB, (uint8_t *)&lecture);
+		}
 
-		if(swap_gauche_droite){
-			I2C_Write(SONAR_ADR_G, SRF10_RANGE_REG, range_sonar);//set la porte a 200cm pour le sonar gauche
-			I2C_Write(SONAR_ADR_G, SRF10_CMD_REG, 0x51); // effectue un ping en cm sur le sonar gauche
+		capteur = (capteur == SONAR_GAUCHE) ? SONAR_DROIT : SONAR_GAUCHE;
+		portee = portee_registre(vitesse);
+		I2C_Write(capteur == SONAR_GAUCHE ? SONAR_ADR_G : SONAR_ADR_D, SRF10_RANGE_REG, portee);
+		I2C_Write(capteur == SONAR_GAUCHE ? SONAR_ADR_G : SONAR_ADR_D, SRF10_CMD_REG, SONAR_PING); // ping en cm
 
-			GPIO_SET(GPIOC,5);
-			GPIO_RESET(GPIOC,4);
+		if(capteur == SONAR_GAUCHE){
+			BROCHE_SET(DEL_PING_GAUCHE);
+			BROCHE_RESET(DEL_PING_DROIT);
+		}else{
+			BROCHE_SET(DEL_PING_DROIT);
+			BROCHE_RESET(DEL_PING_GAUCHE);
+		}
+		ping_fait = 1;
+		ticks_restants = fenetre_ticks(portee, vitesse);
+	}
+	ticks_restants--;
 
-			I2C_Read(SONAR_ADR_D,SRF10_RANGE_LSB,&lsb);
+	*etatGauche = etat_gauche;
+	*etatDroit = etat_droit;
+}
 
-			while(lsb==0);
+/**
+ * @brief  accesseur des distances filtrees des sonars
+ * @param  uint8_t *gauche : distance du sonar gauche (cm)
+ * 		   uint8_t *droit : distance du sonar droit (cm)
+ * @retval None
+ */
+void pull_sonar_distance(uint8_t *gauche, uint8_t *droit){
+	*gauche = sonar_gauche;
+	*droit = sonar_droit;
+}
 
-			sonar_droit = lsb;
+/**
+ * @brief  accesseur du temps avant collision et de la vitesse d'approche de chaque sonar
+ * @param  uint16_t *ttc_gauche : temps avant collision a gauche (ms, FILTRE_TTC_INFINI si rien n'approche)
+ * 		   uint16_t *ttc_droit : temps avant collision a droite (ms)
+ * 		   int16_t *approche_gauche : vitesse d'approche a gauche (cm/s, NULL si non voulue)
+ * 		   int16_t *approche_droit : vitesse d'approche a droite (cm/s, NULL si non voulue)
+ * @retval None
+ */
+void pull_sonar_ttc(uint16_t *ttc_gauche, uint16_t *ttc_droit, int16_t *approche_gauche, int16_t *approche_droit){
+	*ttc_gauche = filtre[SONAR_GAUCHE].ttc;
+	*ttc_droit = filtre[SONAR_DROIT].ttc;
+	if(approche_gauche != NULL)
+		*approche_gauche = filtre[SONAR_GAUCHE].approche;
+	if(approche_droit != NULL)
+		*approche_droit = filtre[SONAR_DROIT].approche;
+}
 
-			swap_gauche_droite=0;
-		}else{
-			I2C_Write(SONAR_ADR_D, SRF10_RANGE_REG, range_sonar);//set la porte a 200cm pour le sonar gauche
-			I2C_Write(SONAR_ADR_D, SRF10_CMD_REG, 0x51); // effectue un ping en cm sur le sonar droit
+/**
+ * @brief  accesseur de la duree de la derniere fenetre d'echo (un sonar est relu
+ *         apres deux fenetres)
+ * @param  None
+ * @retval uint8_t : duree (ms)
+ */
+uint8_t pull_sonar_periode_ms(void){
+	return periode_ms;
+}
 
+/* Private functions ---------------------------------------------------------*/
 
-			GPIO_SET(GPIOC,4);
-			GPIO_RESET(GPIOC,5);
+/**
+ * @brief  Fonction qui calcule la portee du sonar a partir de la vitesse : la marge
+ *         plus la distance d'arret, qui croit avec le carre de la vitesse
+ * @param  float vitesse : vitesse commandee (-1 a 1)
+ * @retval uint8_t : valeur du registre de portee du SRF10 (MINRANGE a MAXRANGE)
+ */
+static uint8_t portee_registre(float vitesse){
+	float distance = SONAR_MARGE_CM + SONAR_ARRET_CM*vitesse*vitesse;
+	float portee = ceilf(distance/RANGE_TO_cm);
 
-			I2C_Read(SONAR_ADR_G,SRF10_RANGE_LSB,&lsb);
+	if(portee < MINRANGE)
+		return MINRANGE;
+	if(portee > MAXRANGE)
+		return MAXRANGE;
+	return (uint8_t)portee;
+}
 
-			while(lsb==0);
+/**
+ * @brief  Fonction qui calcule la duree de la fenetre d'echo : le temps de vol a la portee,
+ *         la garde contre les echos tardifs et une attente qui reduit le nombre de pings
+ *         quand le robot va lentement
+ * @param  uint8_t portee : valeur du registre de portee du SRF10
+ *         float vitesse : vitesse commandee (-1 a 1)
+ * @retval uint8_t : duree en ticks de controle (au moins 1)
+ */
+static uint8_t fenetre_ticks(uint8_t portee, float vitesse){
+	float lenteur = 1.0f - fabsf(vitesse);
+	float duree = portee*RANGE_TO_ms + SONAR_GARDE_MS;
 
-			sonar_gauche = lsb;
+	if(lenteur > 0)
+		duree += lenteur*SONAR_ATTENTE_MS;
+	periode_ms = (uint8_t)duree;
+	return (uint8_t)((duree + CONTROLE_PERIODE_MS - 1)/CONTROLE_PERIODE_MS);
+}
 
-			swap_gauche_droite=1;
-		}
+/**
+ * @brief  Fonction qui met a jour l'etat des obstacles avec les distances filtrees : un cote
+ *         est en alerte si son temps avant collision est sous SONAR_TTC_MS ou si l'objet est
+ *         plus pres que SONAR_DISTANCE_MIN_CM. Le cote le plus urgent l'emporte
+ * @param  None
+ * @retval None
+ */
+static void evaluer_obstacles(void){
+	uint16_t ttc_g = filtre[SONAR_GAUCHE].ttc;
+	uint16_t ttc_d = filtre[SONAR_DROIT].ttc;
+	uint8_t alerte_g = (ttc_g <= SONAR_TTC_MS) || (sonar_gauche <= SONAR_DISTANCE_MIN_CM);
+	uint8_t alerte_d = (ttc_d <= SONAR_TTC_MS) || (sonar_droit <= SONAR_DISTANCE_MIN_CM);
 
-		if((sonar_gauche<=range_activation)&&(sonar_gauche<=sonar_droit)){
-			*etatGauche = 1;
-			*etatDroit = 0;
-			GPIO_SET(GPIOC,3);
-			GPIO_RESET(GPIOC,2);
-		}else if((sonar_droit<=range_activation)&&(sonar_droit<=sonar_gauche)){
-			*etatDroit = 1;
-			*etatGauche = 0;
-			GPIO_SET(GPIOC,2);
-			GPIO_RESET(GPIOC,3);
-		}else{
-			*etatDroit = 0;
-			*etatGauche = 0;
-			GPIO_RESET(GPIOC,2);
-			GPIO_RESET(GPIOC,3);
-		}
-		compteur_nb_5ms=0;
+	if(alerte_g && alerte_d){
+		//les deux cotes : le plus proche de la collision, puis le plus pres
+		if(ttc_g != ttc_d)
+			alerte_g = (ttc_g < ttc_d);
+		else
+			alerte_g = (sonar_gauche <= sonar_droit);
+		alerte_d = !alerte_g;
 	}
-	compteur_nb_5ms++;
 
+	if(alerte_g){
+		etat_gauche = 1;
+		etat_droit = 0;
+		BROCHE_SET(DEL_OBSTACLE_GAUCHE);
+		BROCHE_RESET(DEL_OBSTACLE_DROIT);
+	}else if(alerte_d){
+		etat_droit = 1;
+		etat_gauche = 0;
+		BROCHE_SET(DEL_OBSTACLE_DROIT);
+		BROCHE_RESET(DEL_OBSTACLE_GAUCHE);
+	}else{
+		etat_droit = 0;
+		etat_gauche = 0;
+		BROCHE_RESET(DEL_OBSTACLE_DROIT);
+		BROCHE_RESET(DEL_OBSTACLE_GAUCHE);
+	}
 }
-
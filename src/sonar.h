@@ -33,18 +33,59 @@
 /* Inutilisé : 0x03*/
 #define DISTANCE_ARRET_URGENCE 25;
 
+/* Ordonnancement des pings (task_sonar) */
+#define SONAR_GAIN 			10		//gain maximal du SRF10
+#define SONAR_MARGE_CM 		90.0f	//portee a l'arret
+#define SONAR_ARRET_CM 		110.0f	//distance d'arret a pleine vitesse, ajoutee a la marge
+#define SONAR_GARDE_MS 		5.0f	//attente apres le temps de vol, contre les echos tardifs
+#define SONAR_ATTENTE_MS 	60.0f	//attente ajoutee a l'arret (reduite avec la vitesse)
+/* Detection d'obstacle sur les distances filtrees (filtre_sonar.c) */
+#define SONAR_TTC_MS 			1500	//alerte si la collision est prevue dans moins de 1.5s
+#define SONAR_DISTANCE_MIN_CM 	30		//alerte sous cette distance, meme sans approche
+#define SONAR_HORS_PORTEE_CM 	255		//distance donnee a une lecture sans echo
+
+/* Fenetre la plus longue (MAXRANGE, a l'arret) : 45*0.256 + 5 + 60 = 77ms, un sonar est relu
+ * apres deux fenetres, sous CHIEN_DELAI_SONAR */
+
 /* Type definitions ----------------------------------------------------------*/
 
 /* Function prototypes ------------------------------------------------------ */
 
 /**
- * @brief  Fonction qui renvoie le sonar qui a un objet le plus proche
- * @param  control_struct_t *control : structure de controle pour avoir la vitesse du robot
- * 		   uint8_t *etatDroit : etat du sonar droit (1=obstacle a droite, 0= pas d'obstacle a droite)
+ * @brief  Fonction qui ordonnance les pings des sonars sans attente active et renvoie le sonar
+ *         qui a un objet le plus proche (a appeler a chaque tick de controle). La portee suit
+ *         la vitesse du profil (trajectoire.c)
+ * @param  uint8_t *etatDroit : etat du sonar droit (1=obstacle a droite, 0= pas d'obstacle a droite)
  * 		   uint8_t *etatGauche : etat du sonar gauche (1=obstacle a gauche, 0= pas d'obstacle a gauche)
  * @retval None
  */
-void task_sonar(control_struct_t *control,uint8_t *etatDroit,uint8_t *etatGauche);
+void task_sonar(uint8_t *etatDroit,uint8_t *etatGauche);
+
+/**
+ * @brief  accesseur des distances filtrees des sonars
+ * @param  uint8_t *gauche : distance du sonar gauche (cm)
+ * 		   uint8_t *droit : distance du sonar droit (cm)
+ * @retval None
+ */
+void pull_sonar_distance(uint8_t *gauche, uint8_t *droit);
+
+/**
+ * @brief  accesseur de la duree de la derniere fenetre d'echo (un sonar est relu
+ *         apres deux fenetres)
+ * @param  None
+ * @retval uint8_t : duree (ms)
+ */
+uint8_t pull_sonar_periode_ms(void);
+
+/**
+ * @brief  accesseur du temps avant collision et de la vitesse d'approche de chaque sonar
+ * @param  uint16_t *ttc_gauche : temps avant collision a gauche (ms, FILTRE_TTC_INFINI si rien n'approche)
+ * 		   uint16_t *ttc_droit : temps avant collision a droite (ms)
+ * 		   int16_t *approche_gauche : vitesse d'approche a gauche (cm/s, NULL si non voulue)
+ * 		   int16_t *approche_droit : vitesse d'approche a droite (cm/s, NULL si non voulue)
+ * @retval None
+ */
+void pull_sonar_ttc(uint16_t *ttc_gauche, uint16_t *ttc_droit, int16_t *approche_gauche, int16_t *approche_droit);
 
 
 #endif /* SONAR_H_ */
@@ -91,6 +91,19 @@ LoopFillZerobss:
   cmp r2, r3
   bcc FillZerobss
 
+/* Paint the free RAM between the end of the static data and the stack
+   pointer with PILE_MOTIF (pile.h), to measure the stack high-water mark. */
+  ldr r2, =_end
+  ldr r1, =0xA5C3A5C3
+  mov r3, sp
+  b LoopPaintStack
+PaintStack:
+  str  r1, [r2]
+  adds r2, r2, #4
+LoopPaintStack:
+  cmp r2, r3
+  bcc PaintStack
+
 /* Call the clock system intitialization function.*/
     bl  SystemInit
 /* Call static constructors */
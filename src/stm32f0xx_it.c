@@ -29,6 +29,8 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f0xx_it.h"
+#include "faute.h"
+#include "horloge.h"
     
 /** @addtogroup Template
   * @{
@@ -47,24 +49,40 @@
 
 /**
   * @brief  This function handles NMI exception.
+  *         Seule source : defaillance du HSE detectee par le CSS (horloge.c)
   * @param  None
   * @retval None
   */
 void NMI_Handler(void)
 {
+	horloge_css();
 }
 
 /**
   * @brief  This function handles Hard Fault exception.
+  *         Passe la pile active au moment de la faute (bit 2 de EXC_RETURN : 0 = MSP,
+  *         1 = PSP) et EXC_RETURN a faute_capture, qui coupe les moteurs et redemarre.
+  *         Naked : aucun prologue ne doit toucher a la pile avant la capture.
   * @param  None
   * @retval None
   */
-void HardFault_Handler(void)
+__attribute__((naked)) void HardFault_Handler(void)
 {
-	  /* Go to infinite loop when Hard Fault exception occurs */
-	  while (1)
-	  {
-	  }
+	__asm volatile(
+		"movs r0, #4            \n"
+		"mov  r1, lr            \n"
+		"tst  r0, r1            \n"
+		"beq  1f                \n"
+		"mrs  r0, psp           \n"
+		"b    2f                \n"
+		"1:                     \n"
+		"mrs  r0, msp           \n"
+		"2:                     \n"
+		"ldr  r2, =faute_capture\n"
+		"bx   r2                \n"
+		".align 2               \n"
+		".ltorg                 \n"
+	);
 }
 
 
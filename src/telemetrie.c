@@ -0,0 +1,223 @@
+/**
+ * @file        telemetrie.c
+ * @brief       Binary telemetry stream over USART2.
+ *
+ * @details     Frames (see telemetrie_trame.h) are built in one of two
+ * fixed-size buffers while the USART interrupt sends the other one, so
+ * building a record is a bounded copy plus an 8-bit checksum and never
+ * waits on the link. When the link is saturated the record is dropped and
+ * counted instead. The USART interrupt only starts a frame between two
+ * echo bytes, so frames are never split by the echo of the remote control.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "telemetrie.h"
+#include "usart.h"
+#include "adc.h"
+#include "mission.h"
+#include "liaison.h"
+#include "etage.h"
+#include "sonar.h"
+#include "veille.h"
+#include "odometrie.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t trame[2][TRAME_TAILLE_MAX];	//double tampon de trames
+static uint8_t taille_trame[2];				//taille de chaque trame
+static volatile uint8_t actif = 0;			//tampon en cours d'envoi par l'interruption
+static volatile uint8_t pret = 0;			//1 si le tampon libre contient une trame a envoyer
+static volatile uint8_t en_cours = 0;		//1 si une trame est en cours d'envoi
+static volatile uint8_t position = 0;		//prochain octet a envoyer de la trame active
+
+static uint16_t compteur_decimation = 0;
+static uint16_t sequence = 0;
+static uint8_t perdues = 0;
+static uint16_t duree_boucle = 0;
+static uint16_t duree_max = 0;
+static uint16_t cycles_controle_max = 0;
+static uint8_t depassement_boucle = 0;
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui construit une trame dans le tampon libre et la met en attente d'envoi
+ * @param  uint8_t type : type de la trame (TRAME_*)
+ *         const void *donnees : contenu de la trame
+ *         uint8_t longueur : nombre d'octets de donnees (max TRAME_DONNEES_MAX)
+ * @retval uint8_t : 1 si la trame est en attente d'envoi, 0 si le tampon libre est occupe
+ */
+uint8_t telemetrie_envoyer(uint8_t type, const void *donnees, uint8_t longueur){
+	uint8_t libre;
+	uint8_t *octets;
+	uint8_t somme;
+
+	//La trame precedente n'a pas encore ete prise par l'interruption
+	if(pret || longueur > TRAME_DONNEES_MAX)
+		return 0;
+
+	//actif est lu apres pret : sans trame en attente, l'interruption ne change plus de tampon
+	libre = 1 - actif;
+	octets = trame[libre];
+
+	octets[0] = TRAME_SYNC_1;
+	octets[1] = TRAME_SYNC_2;
+	octets[2] = type;
+	octets[3] = longueur;
+	memcpy(&octets[TRAME_ENTETE], donnees, longueur);
+
+	somme = type + longueur;
+	for(uint8_t i=0;i<longueur;i++)
+		somme += octets[TRAME_ENTETE+i];
+	octets[TRAME_ENTETE+longueur] = somme;
+
+	taille_trame[libre] = TRAME_ENTETE + longueur + 1;
+	pret = 1;
+	usart_demarrer_envoi();
+	return 1;
+}
+
+/**
+ * @brief  Fonction qui construit l'enregistrement de telemetrie aux TELEMETRIE_DECIMATION ticks
+ * @param  control_struct_t *control : structure de controle
+ *         uint8_t etat_sonar_droit : etat du sonar droit
+ *         uint8_t etat_sonar_gauche : etat du sonar gauche
+ *         uint8_t arret_urgence : etat de l'arret d'urgence
+ * @retval None
+ */
+void telemetrie_tache(control_struct_t *control, uint8_t etat_sonar_droit, uint8_t etat_sonar_gauche, uint8_t arret_urgence){
+	trame_telemetrie_t enregistrement;
+	int16_t duty_gauche, duty_droite;
+	uint8_t sonar_gauche, sonar_droit;
+	uint16_t ttc_gauche, ttc_droit;
+	odometrie_pose_t pose;
+	liaison_qualite_t liaison;
+	float vitesse, angle;
+	int32_t v_gauche, v_droite;
+
+	if(++compteur_decimation < TELEMETRIE_DECIMATION)
+		return;
+	compteur_decimation = 0;
+
+	enregistrement.sequence = sequence++;
+	pullConsigne(control, &vitesse, &angle);
+	pullMesure(control, &v_gauche, &v_droite);
+	enregistrement.vitesse = (int16_t)(vitesse*1000);
+	enregistrement.angle = (int16_t)(angle*1000);
+	enregistrement.v_moyenne_gauche = (int16_t)v_gauche;
+	enregistrement.v_moyenne_droite = (int16_t)v_droite;
+	//La structure est compacte : on ne passe pas l'adresse de ses champs (acces non aligne)
+	pull_etage_duty(&duty_gauche, &duty_droite);
+	pull_sonar_distance(&sonar_gauche, &sonar_droit);
+	enregistrement.duty_gauche = duty_gauche;
+	enregistrement.duty_droite = duty_droite;
+	enregistrement.sonar_gauche = sonar_gauche;
+	enregistrement.sonar_droit = sonar_droit;
+
+	enregistrement.drapeaux = telemetrie_drapeaux(etat_sonar_droit, etat_sonar_gauche, arret_urgence)
+			| (depassement_boucle ? TELEM_DEPASSEMENT : 0)
+			| (EXEC_RAM ? TELEM_EXEC_RAM : 0);
+	enregistrement.perdues = perdues;
+	enregistrement.duree_boucle = duree_boucle;
+	enregistrement.duree_max = duree_max;
+	enregistrement.reveil = pull_veille_reveil_us();
+	enregistrement.cycles_controle = cycles_controle_max;
+	enregistrement.cycles_adc = pull_adc_cycles_max();
+	pull_sonar_ttc(&ttc_gauche, &ttc_droit, NULL, NULL);
+	enregistrement.ttc_gauche = ttc_gauche;
+	enregistrement.ttc_droit = ttc_droit;
+	pull_odometrie_pose(&pose);
+	enregistrement.x = (int16_t)((pose.x > 32767) ? 32767 : ((pose.x < -32767) ? -32767 : pose.x));
+	enregistrement.y = (int16_t)((pose.y > 32767) ? 32767 : ((pose.y < -32767) ? -32767 : pose.y));
+	enregistrement.theta = pull_odometrie_theta_mrad();
+	pull_liaison_qualite(&liaison);
+	enregistrement.liaison_debit = liaison.debit;
+	enregistrement.liaison_pertes = liaison.pertes;
+	enregistrement.liaison_etat = liaison.etat;
+	enregistrement.liaison_silence = liaison.silence_max;
+
+	if(telemetrie_envoyer(TRAME_TELEMETRIE, &enregistrement, sizeof(enregistrement))){
+		perdues = 0;
+		duree_max = 0;
+		cycles_controle_max = 0;
+		effacer_adc_cycles_max();
+		effacer_liaison_silence_max();
+		depassement_boucle = 0;
+	}else if(perdues < 0xFF){
+		perdues++;
+	}
+}
+
+/**
+ * @brief  Fonction qui donne les drapeaux d'etat (TELEM_*) du tick courant
+ * @param  uint8_t etat_sonar_droit : etat du sonar droit
+ *         uint8_t etat_sonar_gauche : etat du sonar gauche
+ *         uint8_t arret_urgence : etat de l'arret d'urgence
+ * @retval uint8_t : drapeaux TELEM_*
+ */
+uint8_t telemetrie_drapeaux(uint8_t etat_sonar_droit, uint8_t etat_sonar_gauche, uint8_t arret_urgence){
+	uint8_t defaut = pull_defaut_moteur();
+
+	return (etat_sonar_gauche ? TELEM_SONAR_GAUCHE : 0)
+			| (etat_sonar_droit ? TELEM_SONAR_DROIT : 0)
+			| (arret_urgence ? TELEM_ARRET_URGENCE : 0)
+			| ((defaut & DEFAUT_SURCOURANT) ? TELEM_SURCOURANT : 0)
+			| ((defaut & DEFAUT_BLOCAGE) ? TELEM_BLOCAGE : 0)
+			| (pull_mission_active() ? TELEM_MISSION : 0);
+}
+
+/**
+ * @brief  Fonction qui note la duree de traitement du tick courant (a appeler a la fin du tick)
+ * @param  uint32_t cycles : nombre de cycles depuis le debut du tick
+ *         uint8_t depassement : 1 si le tick suivant est arrive avant la fin du traitement
+ * @retval None
+ */
+void telemetrie_duree_boucle(uint32_t cycles, uint8_t depassement){
+	uint32_t duree = cycles/(SystemCoreClock/1000000);
+
+	duree_boucle = (duree > 0xFFFF) ? 0xFFFF : (uint16_t)duree;
+	if(duree_boucle > duree_max)
+		duree_max = duree_boucle;
+	if(depassement)
+		depassement_boucle = 1;
+}
+
+/**
+ * @brief  Fonction qui note la duree de control_tsk pour comparer l'execution depuis la RAM
+ *         et depuis la flash (EXEC_RAM)
+ * @param  uint32_t cycles : nombre de cycles du coeur
+ * @retval None
+ */
+void telemetrie_cycles_controle(uint32_t cycles){
+	if(cycles > 0xFFFF)
+		cycles = 0xFFFF;
+	if(cycles > cycles_controle_max)
+		cycles_controle_max = (uint16_t)cycles;
+}
+
+/**
+ * @brief  Fonction appelee par l'interruption du USART pour obtenir le prochain octet de trame
+ * @param  uint8_t debut_permis : 1 si une nouvelle trame peut commencer
+ * @retval int16_t : octet a envoyer ou -1 s'il n'y a rien a envoyer
+ */
+int16_t telemetrie_octet_suivant(uint8_t debut_permis){
+	uint8_t octet;
+
+	if(!en_cours){
+		if(!(pret && debut_permis))
+			return -1;
+		//Le tampon libre devient le tampon envoye
+		actif = 1 - actif;
+		pret = 0;
+		position = 0;
+		en_cours = 1;
+	}
+
+	octet = trame[actif][position++];
+	if(position >= taille_trame[actif])
+		en_cours = 0;
+	return octet;
+}
@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ * File Name          : telemetrie.h
+ * Description        : ce module envoie la telemetrie binaire du robot sur le USART2
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef TELEMETRIE_H_
+#define TELEMETRIE_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "telemetrie_trame.h"
+/* Defines -------------------------------------------------------------------*/
+#define TELEMETRIE_DECIMATION 	MS_EN_TICKS(100)	//nb de ticks entre deux enregistrements
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui construit une trame dans le tampon libre et la met en attente d'envoi
+ * @param  uint8_t type : type de la trame (TRAME_*)
+ *         const void *donnees : contenu de la trame
+ *         uint8_t longueur : nombre d'octets de donnees (max TRAME_DONNEES_MAX)
+ * @retval uint8_t : 1 si la trame est en attente d'envoi, 0 si le tampon libre est occupe
+ */
+uint8_t telemetrie_envoyer(uint8_t type, const void *donnees, uint8_t longueur);
+
+/**
+ * @brief  Fonction qui construit l'enregistrement de telemetrie aux TELEMETRIE_DECIMATION ticks
+ * @param  control_struct_t *control : structure de controle
+ *         uint8_t etat_sonar_droit : etat du sonar droit
+ *         uint8_t etat_sonar_gauche : etat du sonar gauche
+ *         uint8_t arret_urgence : etat de l'arret d'urgence
+ * @retval None
+ */
+void telemetrie_tache(control_struct_t *control, uint8_t etat_sonar_droit, uint8_t etat_sonar_gauche, uint8_t arret_urgence);
+
+/**
+ * @brief  Fonction qui donne les drapeaux d'etat (TELEM_*) du tick courant
+ * @param  uint8_t etat_sonar_droit : etat du sonar droit
+ *         uint8_t etat_sonar_gauche : etat du sonar gauche
+ *         uint8_t arret_urgence : etat de l'arret d'urgence
+ * @retval uint8_t : drapeaux TELEM_*
+ */
+uint8_t telemetrie_drapeaux(uint8_t etat_sonar_droit, uint8_t etat_sonar_gauche, uint8_t arret_urgence);
+
+/**
+ * @brief  Fonction qui note la duree de traitement du tick courant (a appeler a la fin du tick)
+ * @param  uint32_t cycles : nombre de cycles depuis le debut du tick
+ *         uint8_t depassement : 1 si le tick suivant est arrive avant la fin du traitement
+ * @retval None
+ */
+void telemetrie_duree_boucle(uint32_t cycles, uint8_t depassement);
+
+/**
+ * @brief  Fonction appelee par l'interruption du USART pour obtenir le prochain octet de trame
+ * @param  uint8_t debut_permis : 1 si une nouvelle trame peut commencer
+ * @retval int16_t : octet a envoyer ou -1 s'il n'y a rien a envoyer
+ */
+int16_t telemetrie_octet_suivant(uint8_t debut_permis);
+
+/**
+ * @brief  Fonction qui note la duree de control_tsk pour comparer l'execution depuis la RAM
+ *         et depuis la flash (EXEC_RAM)
+ * @param  uint32_t cycles : nombre de cycles du coeur
+ * @retval None
+ */
+void telemetrie_cycles_controle(uint32_t cycles);
+
+#endif /* TELEMETRIE_H_ */
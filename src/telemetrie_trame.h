@@ -0,0 +1,185 @@
+/**
+ ******************************************************************************
+ * File Name          : telemetrie_trame.h
+ * Description        : ce module defini le format des trames binaires envoyees sur le USART2
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+/* Ce header ne depend que de stdint.h : il est partage avec les outils de
+ * l'ordinateur hote (tools/) qui decodent les trames.
+ *
+ * Format d'une trame :
+ *   SYNC_1 | SYNC_2 | type | longueur | donnees (longueur octets) | somme
+ * ou somme est la somme sur 8 bits de type, longueur et des donnees.
+ * Toutes les valeurs sur plusieurs octets sont en little endian. */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef TELEMETRIE_TRAME_H_
+#define TELEMETRIE_TRAME_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define TRAME_SYNC_1 		0xA5
+#define TRAME_SYNC_2 		0x5A
+#define TRAME_ENTETE 		4		//sync 1, sync 2, type, longueur
+#define TRAME_DONNEES_MAX 	48
+#define TRAME_TAILLE_MAX 	(TRAME_ENTETE + TRAME_DONNEES_MAX + 1)
+
+/* Types de trame */
+#define TRAME_TELEMETRIE 	0x01
+#define TRAME_ENREGISTREUR 	0x02
+#define TRAME_FAUTE 		0x03	//envoyee une fois au demarrage apres un HardFault
+#define TRAME_DEMARRAGE 	0x04	//cause du reset, envoyee une fois au demarrage
+#define TRAME_PILE 			0x05	//occupation de la RAM, sur demande (commande 0xF3)
+#define TRAME_MISSION 		0x06	//evenement du mode mission (commandes 0xF4 a 0xF6)
+
+/* Drapeaux de trame_telemetrie_t.drapeaux */
+#define TELEM_SONAR_GAUCHE 	0x01
+#define TELEM_SONAR_DROIT 	0x02
+#define TELEM_ARRET_URGENCE 0x04
+#define TELEM_SURCOURANT 	0x08
+#define TELEM_BLOCAGE 		0x10
+#define TELEM_DEPASSEMENT 	0x20	//le traitement d'un tick a depasse la periode de controle
+#define TELEM_EXEC_RAM 		0x40	//le chemin critique s'execute depuis la RAM (EXEC_RAM)
+#define TELEM_MISSION 		0x80	//une mission est en cours, les consignes de la telecommande sont ignorees
+
+/* Cause du reset (trame_demarrage_t.cause, octet de poids fort de RCC_CSR) */
+#define DEMARRAGE_OBL 		0x02	//chargement des option bytes
+#define DEMARRAGE_PIN 		0x04	//broche NRST
+#define DEMARRAGE_POR 		0x08	//mise sous tension
+#define DEMARRAGE_LOGICIEL 	0x10	//NVIC_SystemReset (HardFault)
+#define DEMARRAGE_IWDG 		0x20	//chien de garde independant
+#define DEMARRAGE_WWDG 		0x40
+#define DEMARRAGE_BASSE_CONSO 0x80
+
+/* Evenement du mode mission (trame_mission_t.evenement) */
+#define MISSION_RECUE 		1		//liste d'etapes recue et valide
+#define MISSION_REFUSEE 	2		//liste invalide (somme, nombre), ou depart impossible
+#define MISSION_DEPART 		3
+#define MISSION_ETAPE 		4		//l'etape trame_mission_t.etape est atteinte
+#define MISSION_TERMINEE 	5
+#define MISSION_ABANDON 	6		//commande 0xF6 ou arret d'urgence
+
+/* Source de l'horloge (trame_demarrage_t.horloge) */
+#define HORLOGE_HSE_PLL 	0		//quartz de 8MHz et PLL a 48MHz
+#define HORLOGE_HSI_PLL 	1		//HSE en defaut : HSI/2 et PLL a 48MHz
+#define HORLOGE_HSI 		2		//PLL en defaut : HSI a 8MHz
+
+/* Cause du gel de l'enregistreur (trame_enregistreur_t.cause) */
+#define ENREG_ARME 			0		//l'enregistreur n'est pas gele
+#define ENREG_ARRET_URGENCE 1
+#define ENREG_DEFAUT 		2		//defaut moteur du watchdog analogique
+#define ENREG_COMMANDE 		3		//demande par le USART
+#define ENREG_REDEMARRAGE 	4		//contenu conserve apres un reset sans cause connue
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct __attribute__((packed)) {
+	uint16_t sequence;			//numero de l'enregistrement
+	int16_t vitesse;			//vitesse commandee (1/1000, -1000 a 1000)
+	int16_t angle;				//angle commande (mrad)
+	int16_t v_moyenne_gauche;	//mesure moyenne de l'ADC du moteur gauche
+	int16_t v_moyenne_droite;	//mesure moyenne de l'ADC du moteur droit
+	int16_t duty_gauche;		//duty applique au moteur gauche (1/10000)
+	int16_t duty_droite;		//duty applique au moteur droit (1/10000)
+	uint8_t sonar_gauche;		//distance du sonar gauche (cm)
+	uint8_t sonar_droit;		//distance du sonar droit (cm)
+	uint8_t drapeaux;			//TELEM_*
+	uint8_t perdues;			//nb d'enregistrements non envoyes (lien sature)
+	uint16_t duree_boucle;		//duree du dernier tick (us depuis le debut du tick)
+	uint16_t duree_max;			//duree maximale d'un tick depuis l'enregistrement precedent (us)
+	uint16_t reveil;			//duree de la derniere sortie de veille (us)
+	uint16_t cycles_controle;	//duree maximale de control_tsk depuis l'enregistrement precedent (cycles)
+	uint16_t cycles_adc;		//duree maximale de l'interruption de l'ADC depuis l'enregistrement precedent (cycles)
+	uint16_t ttc_gauche;		//temps avant collision a gauche (ms, 0xFFFF si rien n'approche)
+	uint16_t ttc_droit;			//temps avant collision a droite (ms)
+	int16_t x;					//position estimee par l'odometrie (mm, saturee a +/-32767)
+	int16_t y;					//position estimee a gauche de l'axe de depart (mm)
+	int16_t theta;				//cap estime par l'odometrie (mrad, -pi a pi)
+	uint8_t liaison_debit;		//trames de la telecommande recues pendant la derniere seconde
+	uint8_t liaison_pertes;		//nb de pertes de la liaison depuis le demarrage (sature a 255)
+	uint8_t liaison_etat;		//LIAISON_* (liaison.h)
+	uint16_t liaison_silence;	//plus long silence de la liaison depuis l'enregistrement precedent (ms)
+} trame_telemetrie_t;
+
+/* Une entree de l'enregistreur de vol, une par tick de controle */
+typedef struct __attribute__((packed, aligned(2))) {
+	uint16_t tick;				//numero du tick (16 bits de poids faible)
+	int16_t vitesse;			//vitesse commandee (1/1000)
+	int16_t angle;				//angle commande (mrad)
+	int16_t v_moyenne_gauche;	//mesure moyenne de l'ADC du moteur gauche
+	int16_t v_moyenne_droite;	//mesure moyenne de l'ADC du moteur droit
+	int16_t duty_gauche;		//duty applique au moteur gauche (1/10000)
+	int16_t duty_droite;		//duty applique au moteur droit (1/10000)
+	int16_t angle_estime;		//angle estime par l'asservissement (mrad)
+	int16_t w;					//vitesse angulaire estimee par l'asservissement (mrad/s)
+	uint8_t sonar_gauche;		//distance du sonar gauche (cm)
+	uint8_t sonar_droit;		//distance du sonar droit (cm)
+	uint8_t drapeaux;			//TELEM_*
+	uint8_t commande;			//derniere commande de la telecommande
+} enregistrement_vol_t;
+
+typedef struct __attribute__((packed, aligned(2))) {
+	uint8_t index;				//position de l'entree, 0 = la plus ancienne
+	uint8_t nombre;				//nombre d'entrees du vidage
+	uint8_t cause;				//ENREG_*
+	uint8_t reserve;
+	enregistrement_vol_t entree;
+} trame_enregistreur_t;
+
+/* Contexte d'un HardFault, capture par le gestionnaire et rapporte au demarrage suivant */
+typedef struct __attribute__((packed, aligned(4))) {
+	uint32_t pc;				//adresse de l'instruction fautive (pile d'exception)
+	uint32_t lr;				//LR de la fonction fautive
+	uint32_t xpsr;				//xPSR, le champ IPSR donne l'interruption active
+	uint32_t r0;
+	uint32_t r1;
+	uint32_t r2;
+	uint32_t r3;
+	uint32_t r12;
+	uint32_t sp;				//pointeur de pile au moment de la faute (avant l'empilement)
+	uint32_t exc_return;		//LR du gestionnaire (0xFFFFFFF9 : MSP, 0xFFFFFFFD : PSP)
+	uint16_t compteur;			//nb de HardFault depuis la mise sous tension
+	uint16_t pile_valide;		//0 si le pointeur de pile n'etait pas dans la RAM
+} trame_faute_t;
+
+/* Rapport de demarrage (chien.c) */
+typedef struct __attribute__((packed)) {
+	uint8_t cause;				//DEMARRAGE_*
+	uint8_t tache_manquee;		//taches en retard avant un reset du IWDG (CHIEN_* de chien.h)
+	uint16_t compteur_chien;	//nb de reset du IWDG depuis la mise sous tension
+	uint8_t horloge;			//HORLOGE_*
+	uint8_t reserve;
+} trame_demarrage_t;
+
+/* Occupation de la RAM (pile.c), en octets */
+typedef struct __attribute__((packed)) {
+	uint16_t statique;			//.data, .bss et .noinit
+	uint16_t pile_max;			//niveau maximal de la pile depuis le demarrage
+	uint16_t pile_libre;		//RAM jamais touchee entre les donnees statiques et la pile
+	uint16_t pile_actuelle;		//pile utilisee au moment de la mesure
+} trame_pile_t;
+
+/* Evenement du mode mission (mission.c) */
+typedef struct __attribute__((packed)) {
+	uint8_t evenement;			//MISSION_*
+	uint8_t etape;				//etape concernee (0 = la premiere)
+	uint8_t nombre;				//nombre d'etapes de la mission
+	uint8_t reserve;
+	int16_t x;					//pose de l'odometrie au moment de l'evenement (mm)
+	int16_t y;
+	int16_t theta;				//(mrad)
+	uint16_t distance;			//distance restante jusqu'au point vise (cm, 0 hors d'une etape de point)
+} trame_mission_t;
+
+/* Chaque enregistrement doit tenir dans une trame (verifie a la compilation) */
+_Static_assert(sizeof(trame_telemetrie_t) <= TRAME_DONNEES_MAX, "trame_telemetrie_t depasse TRAME_DONNEES_MAX");
+_Static_assert(sizeof(trame_enregistreur_t) <= TRAME_DONNEES_MAX, "trame_enregistreur_t depasse TRAME_DONNEES_MAX");
+_Static_assert(sizeof(trame_faute_t) <= TRAME_DONNEES_MAX, "trame_faute_t depasse TRAME_DONNEES_MAX");
+_Static_assert(sizeof(trame_demarrage_t) <= TRAME_DONNEES_MAX, "trame_demarrage_t depasse TRAME_DONNEES_MAX");
+_Static_assert(sizeof(trame_pile_t) <= TRAME_DONNEES_MAX, "trame_pile_t depasse TRAME_DONNEES_MAX");
+_Static_assert(sizeof(trame_mission_t) <= TRAME_DONNEES_MAX, "trame_mission_t depasse TRAME_DONNEES_MAX");
+
+#endif /* TELEMETRIE_TRAME_H_ */
@@ -0,0 +1,179 @@
+/**
+ * @file        trajectoire.c
+ * @brief       Jerk-limited speed and heading profiles.
+ *
+ * @details     Sits between the remote setpoints (updateVitesse_angle) and
+ * the controller. A step of the commanded speed or heading becomes an
+ * S-curve, so the controller follows a reachable reference instead of
+ * saturating Ut and Ua for many ticks.
+ *
+ * The profiles are advanced one tick at a time with O(1) work, with no
+ * precomputed table.
+ * - Speed: the acceleration aims at the largest value from which the speed
+ *   error e can still be cancelled with the jerk limit. The continuous
+ *   bound sqrt(2*jerk*|e|) is lowered by half a tick of jerk, because the
+ *   acceleration only drops by one jerk step per tick. The acceleration
+ *   moves toward that target by at most one tick of jerk.
+ * - Heading: the same rule on the angle and the angular speed gives a
+ *   trapezoidal profile (angular acceleration limited). Its steps are then
+ *   averaged over alpha/(jerk*T) ticks with a running sum. The average of
+ *   a trapezoid is an S-curve that limits the jerk, and it ends on the
+ *   same angle. The heading error is taken the short way around the circle.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include "trajectoire.h"
+#include "moteur.h"
+
+/* Private variables ---------------------------------------------------------*/
+static trajectoire_limites_t limites = { TRAJ_ACCEL, TRAJ_JERK, TRAJ_W_MAX, TRAJ_ALPHA, TRAJ_JERK_ANGLE };
+static trajectoire_t profil = { .longueur = (uint8_t)(TRAJ_ALPHA/(TRAJ_JERK_ANGLE*TRAJ_PERIODE_S) + 0.5f) };
+
+/* Private function prototypes -----------------------------------------------*/
+static void suivre(float *valeur, float *derivee, float ecart, float derivee_max, float jerk);
+static uint8_t longueur_lissage(void);
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui change les limites des profils (la longueur de la moyenne mobile du cap
+ *         change quand le cap est au repos)
+ * @param  const trajectoire_limites_t *nouvelles : nouvelles limites (toutes positives)
+ * @retval None
+ */
+void trajectoire_configurer(const trajectoire_limites_t *nouvelles){
+	limites = *nouvelles;
+}
+
+/**
+ * @brief  Fonction qui arrete le profil : vitesse nulle et angle a l'angle estime par
+ *         l'asservissement (au demarrage et apres un arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void trajectoire_reset(void){
+	float angle, w;
+
+	CalculPWM_Etat(&angle, &w);
+	profil.vitesse = 0;
+	profil.accel = 0;
+	profil.angle = angle;
+	profil.w = 0;
+	profil.angle_trapeze = angle;
+	profil.w_trapeze = 0;
+	for(uint8_t i=0;i<TRAJ_LISSAGE_MAX;i++)
+		profil.pas[i] = 0;
+	profil.somme = 0;
+	profil.index = 0;
+	profil.longueur = longueur_lissage();
+	profil.repos = 0;
+}
+
+/**
+ * @brief  Fonction qui avance les profils d'un tick vers les consignes (a appeler aux 5ms)
+ * @param  float vitesse : consigne de vitesse (-1 a 1)
+ *         float angle : consigne d'angle (rad)
+ * @retval None
+ */
+void trajectoire_tache(float vitesse, float angle){
+	float ecart, ancien, pas;
+
+	//Vitesse : S-curve de la vitesse (acceleration et jerk limites)
+	suivre(&profil.vitesse, &profil.accel, vitesse - profil.vitesse, limites.accel, limites.jerk);
+
+	//Cap : trapeze (vitesse et acceleration angulaires limitees), ecart par le plus court chemin
+	ecart = angle - profil.angle_trapeze;
+	ecart -= 2*TRAJ_PI*floorf((ecart + TRAJ_PI)/(2*TRAJ_PI));
+	ancien = profil.angle_trapeze;
+	suivre(&profil.angle_trapeze, &profil.w_trapeze, ecart, limites.w_max, limites.alpha);
+	pas = profil.angle_trapeze - ancien;
+	profil.angle_trapeze -= 2*TRAJ_PI*floorf(profil.angle_trapeze/(2*TRAJ_PI));
+
+	//Moyenne mobile des pas du trapeze : le jerk angulaire est limite a alpha/(longueur*T)
+	profil.somme += pas - profil.pas[profil.index];
+	profil.pas[profil.index] = pas;
+	profil.index = (profil.index + 1 < profil.longueur) ? profil.index + 1 : 0;
+	profil.w = profil.somme/(profil.longueur*TRAJ_PERIODE_S);
+	profil.angle += profil.somme/profil.longueur;
+
+	//Trapeze arrete depuis toute la moyenne : on efface l'erreur d'arrondi de la somme
+	profil.repos = (pas != 0) ? 0 : ((profil.repos < 0xFF) ? profil.repos + 1 : 0xFF);
+	if(profil.repos >= profil.longueur){
+		profil.somme = 0;
+		profil.w = 0;
+		profil.angle = profil.angle_trapeze;
+		profil.index = 0;
+		profil.longueur = longueur_lissage();
+	}
+	profil.angle -= 2*TRAJ_PI*floorf(profil.angle/(2*TRAJ_PI));	//entre 0 et 2 pi
+}
+
+/**
+ * @brief  accesseur de la vitesse et de l'angle du profil
+ * @param  float *vitesse : vitesse a donner a l'asservissement (-1 a 1)
+ *         float *angle : angle a donner a l'asservissement (0 a 2 pi)
+ * @retval None
+ */
+void pull_trajectoire(float *vitesse, float *angle){
+	*vitesse = profil.vitesse;
+	*angle = profil.angle;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui avance une valeur d'un tick vers sa consigne : sa derivee vise la plus
+ *         grande valeur qui permet encore d'annuler l'ecart avec le jerk (moins un demi pas,
+ *         la derivee ne descend que d'un pas par tick), et ne change que d'un tick de jerk.
+ *         Une fois l'ecart plus petit qu'un pas, la valeur s'y place
+ * @param  float *valeur : valeur du profil
+ *         float *derivee : derivee de la valeur
+ *         float ecart : consigne - valeur
+ *         float derivee_max : limite de la derivee
+ *         float jerk : limite de la derivee seconde
+ * @retval None
+ */
+static void suivre(float *valeur, float *derivee, float ecart, float derivee_max, float jerk){
+	float pas = jerk*TRAJ_PERIODE_S;
+	float cible = sqrtf(2*jerk*fabsf(ecart)) - pas/2;	//sans le demi pas, la valeur depasse la consigne
+
+	if(cible < 0)
+		cible = 0;
+	if(cible > derivee_max)
+		cible = derivee_max;
+	if(ecart < 0)
+		cible = -cible;
+
+	if(cible > *derivee + pas)
+		*derivee += pas;
+	else if(cible < *derivee - pas)
+		*derivee -= pas;
+	else
+		*derivee = cible;
+
+	if(fabsf(ecart) <= pas*TRAJ_PERIODE_S && fabsf(*derivee) <= pas){
+		*valeur += ecart;
+		*derivee = 0;
+	}else{
+		*valeur += *derivee*TRAJ_PERIODE_S;
+	}
+}
+
+/**
+ * @brief  Fonction qui calcule la longueur de la moyenne mobile du cap : alpha/(jerk*T) ticks
+ * @param  None
+ * @retval uint8_t : longueur (1 a TRAJ_LISSAGE_MAX)
+ */
+static uint8_t longueur_lissage(void){
+	float longueur = limites.alpha/(limites.jerk_angle*TRAJ_PERIODE_S) + 0.5f;
+
+	if(longueur < 1)
+		return 1;
+	if(longueur > TRAJ_LISSAGE_MAX)
+		return TRAJ_LISSAGE_MAX;
+	return (uint8_t)longueur;
+}
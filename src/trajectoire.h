@@ -0,0 +1,86 @@
+/**
+ ******************************************************************************
+ * File Name          : trajectoire.h
+ * Description        : ce module transforme les consignes de vitesse et d'angle de la
+ * 						telecommande en profils lisses (acceleration et jerk limites)
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef TRAJECTOIRE_H_
+#define TRAJECTOIRE_H_
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "carte.h"
+/* Defines -------------------------------------------------------------------*/
+#define TRAJ_PERIODE_S 		(CONTROLE_PERIODE_MS/1000.0f)
+/* Limites par defaut (vitesse en pleine echelle, -1 a 1) */
+#define TRAJ_ACCEL 			1.0f	//acceleration maximale (1/s) : 0 a pleine vitesse en 1s (le moteur, Tau = 0.5s, suit)
+#define TRAJ_JERK 			8.0f	//jerk maximal (1/s^2) : acceleration atteinte en 125ms
+/* Limites par defaut du cap */
+#define TRAJ_W_MAX 			1.5f	//vitesse angulaire maximale (rad/s)
+#define TRAJ_ALPHA 			6.0f	//acceleration angulaire maximale (rad/s^2)
+#define TRAJ_JERK_ANGLE 	48.0f	//jerk angulaire maximal (rad/s^3) : moyenne mobile de 25 ticks
+#define TRAJ_PI 			3.14159265f
+#define TRAJ_LISSAGE_MAX 	32		//longueur maximale de la moyenne mobile du cap (ticks)
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	float accel;		//acceleration maximale de la vitesse (1/s)
+	float jerk;			//jerk maximal de la vitesse (1/s^2)
+	float w_max;		//vitesse angulaire maximale (rad/s)
+	float alpha;		//acceleration angulaire maximale (rad/s^2)
+	float jerk_angle;	//jerk angulaire maximal (rad/s^3), au moins alpha/(TRAJ_LISSAGE_MAX*T)
+} trajectoire_limites_t;
+
+typedef struct {
+	float vitesse;		//vitesse du profil (-1 a 1)
+	float accel;		//derivee de la vitesse (1/s)
+	float angle;		//angle du profil (0 a 2 pi)
+	float w;			//vitesse angulaire du profil (rad/s)
+	/* Profil trapezoidal du cap, avant la moyenne mobile */
+	float angle_trapeze;			//angle (0 a 2 pi)
+	float w_trapeze;				//vitesse angulaire (rad/s)
+	float pas[TRAJ_LISSAGE_MAX];	//derniers pas d'angle du trapeze (rad)
+	float somme;					//somme des pas de la moyenne mobile (rad)
+	uint8_t index;					//prochaine case de pas
+	uint8_t longueur;				//longueur de la moyenne mobile (ticks)
+	uint8_t repos;					//nb de ticks depuis que le trapeze est arrete
+} trajectoire_t;
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui change les limites des profils
+ * @param  const trajectoire_limites_t *limites : nouvelles limites (toutes positives)
+ * @retval None
+ */
+void trajectoire_configurer(const trajectoire_limites_t *limites);
+
+/**
+ * @brief  Fonction qui arrete le profil : vitesse nulle et angle a l'angle estime par
+ *         l'asservissement (au demarrage et apres un arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void trajectoire_reset(void);
+
+/**
+ * @brief  Fonction qui avance les profils d'un tick vers les consignes (a appeler aux 5ms)
+ * @param  float vitesse : consigne de vitesse (-1 a 1)
+ *         float angle : consigne d'angle (rad)
+ * @retval None
+ */
+void trajectoire_tache(float vitesse, float angle);
+
+/**
+ * @brief  accesseur de la vitesse et de l'angle du profil
+ * @param  float *vitesse : vitesse a donner a l'asservissement (-1 a 1)
+ *         float *angle : angle a donner a l'asservissement (0 a 2 pi)
+ * @retval None
+ */
+void pull_trajectoire(float *vitesse, float *angle);
+
+#endif /* TRAJECTOIRE_H_ */
@@ -0,0 +1,150 @@
+/**
+ * @file        urgence.c
+ * @brief       Module for the emergency stop and start buttons.
+ *
+ * @details     The emergency stop (PB1) and start (PB0) buttons are wired to
+ * EXTI lines 0 and 1 at the highest NVIC priority. A press on PB1 cuts the
+ * motors directly from the interrupt and latches the emergency stop, so the
+ * stop latency does not depend on the main loop (e.g. while it waits on a
+ * sonar). The 5ms task debounces the buttons: PB0 must stay pressed for
+ * URGENCE_DEBOUNCE ticks to release the stop, and the PB1 line is masked
+ * while its contact bounces.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "urgence.h"
+#include "pwm.h"
+
+/* Private variables ---------------------------------------------------------*/
+static volatile uint8_t arret_urgence = 0;		//Etat verrouille de l'arret d'urgence
+static volatile uint8_t appui_marche = 0;		//Front montant detecte sur PB0
+static uint8_t compteur_marche = 0;				//Nb de ticks que PB0 est stable
+static volatile uint8_t compteur_arret = 0;		//Nb de ticks que PB1 est relache (remis a 0 par l'interruption)
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui configure les boutons PB0 et PB1 en interruption externe
+ * @param  None
+ * @retval None
+ */
+void config_urgence(void){
+	BROCHE_MODE(BOUTON_MARCHE,GPIO_INPUT);	//bouton de marche en entree
+	BROCHE_MODE(BOUTON_ARRET,GPIO_INPUT);	//bouton d'arret en entree
+
+	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGCOMPEN;
+
+	//La ligne EXTIn est reliee a la broche n du port du bouton (4 bits par ligne)
+	SYSCFG->EXTICR[0] = (SYSCFG->EXTICR[0] & ~(BOUTON_EXTICR(BOUTON_MARCHE, 0xF)|BOUTON_EXTICR(BOUTON_ARRET, 0xF)))
+			| BOUTON_EXTICR(BOUTON_MARCHE, BOUTON_MARCHE_PORT) | BOUTON_EXTICR(BOUTON_ARRET, BOUTON_ARRET_PORT);
+
+	EXTI->RTSR |= (LIGNE_MARCHE|LIGNE_ARRET);	//Front montant (bouton appuye)
+	EXTI->FTSR &= ~(LIGNE_MARCHE|LIGNE_ARRET);
+	EXTI->PR = (LIGNE_MARCHE|LIGNE_ARRET);
+	EXTI->IMR |= (LIGNE_MARCHE|LIGNE_ARRET);
+
+	NVIC_SetPriority(EXTI0_1_IRQn, PRIORITE_URGENCE);
+	NVIC_EnableIRQ(EXTI0_1_IRQn);
+}
+
+/**
+ * @brief  Fonction qui coupe les moteurs et verrouille l'arret d'urgence
+ *         Peut etre appelee depuis une interruption
+ * @param  None
+ * @retval None
+ */
+void declencher_arret_urgence(void){
+	arret_moteur();
+	arret_urgence = 1;
+}
+
+/**
+ * @brief  Fonction qui fait l'anti-rebond des boutons et valide la remise en marche, qui
+ *         libere les moteurs (a appeler aux 5ms)
+ * @param  uint8_t marche_permise : 0 si une autre source (telecommande) interdit la remise en marche
+ * @retval uint8_t : 1 si la remise en marche a ete validee pendant cet appel sinon 0
+ */
+uint8_t tache_urgence(uint8_t marche_permise){
+	uint8_t marche_validee = 0;
+	uint32_t primask;
+
+	/*
+	 * la ligne de PB1 est masquee pendant les rebonds, on la reactive
+	 * quand le bouton est relache depuis URGENCE_DEBOUNCE ticks.
+	 * compteur_arret est aussi remis a 0 par l'interruption : l'increment
+	 * se fait sans interruption pour ne pas ecraser cette remise a 0
+	 */
+	primask = __get_PRIMASK();
+	__set_PRIMASK(1);
+	if(BROCHE_READ(BOUTON_ARRET)){
+		compteur_arret = 0;
+		arret_urgence = 1;//un bouton d'arret maintenu garde l'arret
+	}else if(compteur_arret < URGENCE_DEBOUNCE){
+		compteur_arret++;
+	}else if((EXTI->IMR & LIGNE_ARRET) == 0){
+		EXTI->PR = LIGNE_ARRET;
+		EXTI->IMR |= LIGNE_ARRET;
+	}
+	__set_PRIMASK(primask);
+
+	/*
+	 * la remise en marche demande que PB0 reste appuye URGENCE_DEBOUNCE ticks
+	 */
+	if(appui_marche && BROCHE_READ(BOUTON_MARCHE)){
+		if(compteur_marche < URGENCE_DEBOUNCE){
+			compteur_marche++;
+		}else{
+			appui_marche = 0;
+			compteur_marche = 0;
+			/*
+			 * lecture et effacement de l'arret sans interruption : un appui sur PB1
+			 * entre les deux n'est pas perdu, et compteur_arret remis a 0 par
+			 * l'interruption annule la remise en marche
+			 */
+			primask = __get_PRIMASK();
+			__set_PRIMASK(1);
+			if(marche_permise && compteur_arret >= URGENCE_DEBOUNCE){
+				marche_validee = arret_urgence;
+				arret_urgence = 0;
+				if(marche_validee)
+					liberer_moteur();// dans la section : un arret_moteur ne peut pas etre annule
+			}
+			__set_PRIMASK(primask);
+		}
+	}else{
+		appui_marche = 0;
+		compteur_marche = 0;
+	}
+
+	return marche_validee;
+}
+
+/**
+ * @brief  accesseur de l'etat d'arret d'urgence
+ * @param  None
+ * @retval uint8_t : 1 si l'arret d'urgence est verrouille sinon 0
+ */
+uint8_t pull_arret_urgence(void){
+	return arret_urgence;
+}
+
+/**
+ * @brief  interuption des boutons d'arret d'urgence et de mise en marche
+ * @param  None
+ * @retval None
+ */
+void EXTI0_1_IRQHandler(void){
+	if(EXTI->PR & LIGNE_ARRET){
+		declencher_arret_urgence();
+		compteur_arret = 0;
+		EXTI->IMR &= ~LIGNE_ARRET;	//masque les rebonds, reactive par tache_urgence
+		EXTI->PR = LIGNE_ARRET;
+	}
+	if(EXTI->PR & LIGNE_MARCHE){
+		appui_marche = 1;
+		EXTI->PR = LIGNE_MARCHE;
+	}
+}
@@ -0,0 +1,54 @@
+/**
+ ******************************************************************************
+ * File Name          : urgence.h
+ * Description        : ce module s'occupe de l'arret d'urgence et de la remise en marche
+ * 						par interruption externe (EXTI) sur les boutons PB0 et PB1
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef URGENCE_H_
+#define URGENCE_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+/* Defines -------------------------------------------------------------------*/
+#define LIGNE_MARCHE 		BROCHE_MASQUE(BOUTON_MARCHE)	//ligne EXTI du bouton de marche
+#define LIGNE_ARRET 		BROCHE_MASQUE(BOUTON_ARRET)		//ligne EXTI du bouton d'arret
+#define BOUTON_EXTICR(nom, valeur) 	((uint32_t)(valeur) << ((nom##_PIN)*4))	//champ de SYSCFG->EXTICR[0]
+#define URGENCE_DEBOUNCE 	MS_EN_TICKS(20)	//nb de ticks de niveau stable pour valider un bouton
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui configure les boutons PB0 et PB1 en interruption externe
+ * @param  None
+ * @retval None
+ */
+void config_urgence(void);
+
+/**
+ * @brief  Fonction qui coupe les moteurs et verrouille l'arret d'urgence
+ *         Peut etre appelee depuis une interruption
+ * @param  None
+ * @retval None
+ */
+void declencher_arret_urgence(void);
+
+/**
+ * @brief  Fonction qui fait l'anti-rebond des boutons et valide la remise en marche, qui
+ *         libere les moteurs (a appeler aux 5ms)
+ * @param  uint8_t marche_permise : 0 si une autre source (telecommande) interdit la remise en marche
+ * @retval uint8_t : 1 si la remise en marche a ete validee pendant cet appel sinon 0
+ */
+uint8_t tache_urgence(uint8_t marche_permise);
+
+/**
+ * @brief  accesseur de l'etat d'arret d'urgence
+ * @param  None
+ * @retval uint8_t : 1 si l'arret d'urgence est verrouille sinon 0
+ */
+uint8_t pull_arret_urgence(void);
+
+#endif /* URGENCE_H_ */
@@ -16,6 +16,12 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "usart.h"
+#include "telemetrie.h"
+#include "enregistreur.h"
+#include "pile.h"
+#include "mission.h"
+#include "liaison.h"
+#include "horloge.h"
 
 /* Private variables ---------------------------------------------------------*/
 static uint8_t etat = 0;
@@ -30,16 +36,16 @@ uint8_t toggle_led_uart = 0;
 void config_uart2(void){
 
 	//Configuration des GPIO
-	GPIO_MODE_CONFIG(GPIOA, 2, GPIO_ALT_FUNC); 		//On defini la pin 2 du port A comme une fonction alternative (USART)
-	GPIO_MODE_CONFIG(GPIOA, 3, GPIO_ALT_FUNC); 		//On defini la pin 3 du port A comme une fonction alternative (USART)
-	GPIO_OTYPE_CONFIG(GPIOA, 2, 0);					// Push-pull
-	GPIO_OTYPE_CONFIG(GPIOA, 3, 1);					// Open-Drain
-	GPIOA->PUPDR |= GPIO_PUPDR_PUPDR2_0; 			//Active la pull-up
-	GPIOA->PUPDR |= GPIO_PUPDR_PUPDR3_0; 			//Active la pull-up
-	GPIOA->OSPEEDR &= ~ GPIO_OSPEEDR_OSPEEDR2_0;	//On defini la vitesse du slew rate du TX a 2MHz
-	GPIOA->OSPEEDR &= ~ GPIO_OSPEEDR_OSPEEDR3_0;	//On defini la vitesse du slew rate du RX a 2MHz
-	GPIO_ALTFUN_CONFIG(GPIOA, 2, 1);				//On assigne la pin 2 du port A au peripherique USART
-	GPIO_ALTFUN_CONFIG(GPIOA, 3, 1);				//On assigne la pin 3 du port A au peripherique USART
+	BROCHE_MODE(USART_TX, GPIO_ALT_FUNC); 			//On defini la broche TX comme une fonction alternative (USART)
+	BROCHE_MODE(USART_RX, GPIO_ALT_FUNC); 			//On defini la broche RX comme une fonction alternative (USART)
+	GPIO_OTYPE_CONFIG(BROCHE_GPIO(USART_TX), USART_TX_PIN, GPIO_PUSH_PULL);
+	GPIO_OTYPE_CONFIG(BROCHE_GPIO(USART_RX), USART_RX_PIN, GPIO_OPEN_DRAIN);
+	GPIO_PUPD_CONFIG(BROCHE_GPIO(USART_TX), USART_TX_PIN, PULL_UP); 	//Active la pull-up
+	GPIO_PUPD_CONFIG(BROCHE_GPIO(USART_RX), USART_RX_PIN, PULL_UP); 	//Active la pull-up
+	BROCHE_GPIO(USART_TX)->OSPEEDR &= ~(1UL<<(USART_TX_PIN*2));	//On defini la vitesse du slew rate du TX a 2MHz
+	BROCHE_GPIO(USART_RX)->OSPEEDR &= ~(1UL<<(USART_RX_PIN*2));	//On defini la vitesse du slew rate du RX a 2MHz
+	GPIO_ALTFUN_CONFIG(BROCHE_GPIO(USART_TX), USART_TX_PIN, USART_AF);	//On assigne la broche TX au peripherique USART
+	GPIO_ALTFUN_CONFIG(BROCHE_GPIO(USART_RX), USART_RX_PIN, USART_AF);	//On assigne la broche RX au peripherique USART
 
 	RCC->APB1ENR |= RCC_APB1ENR_USART2EN;
 
@@ -49,7 +55,7 @@ void config_uart2(void){
 
 	USART2->CR2 &= ~USART_CR2_STOP; 	//On veut 1 seul STOP bit
 
-	USART_CONFIG_BRR(USART2, 5000, 0);	//On defini la vitesse du Baud Rate a 9600
+	usart_horloge(pull_horloge_hz());	//On defini la vitesse du Baud Rate a USART_BAUD
 
 	USART2->CR1 |= USART_CR1_TE;	//On active le transmetteur
 	USART2->CR1 |= USART_CR1_RE;	//On active le recepteur
@@ -59,8 +65,8 @@ void config_uart2(void){
 	USART2->CR1 |= USART_CR1_RXNEIE; 	//Les interruptions sont permise
 	USART2->CR3 |= USART_CR3_EIE; 		//On permet a l'interruption d'erreur de s'activer
 
-	NVIC->IP[7] |= NICE;		//On donne un noveau de priorite a l'interruption
-	NVIC->ISER[0] |= 1<<28;		//On permet a la routine d'etre declanche
+	NVIC_SetPriority(USART2_IRQn, PRIORITE_USART);	//On donne un niveau de priorite a l'interruption
+	NVIC_EnableIRQ(USART2_IRQn);					//On permet a la routine d'etre declanche
 
 	// On cree 2 nouveaux buffer pour recevoir et envoyer des donnees en UART
 	buffer_new(&buffer_telecommande_reception,data_reception_usart,30);
@@ -68,6 +74,22 @@ void config_uart2(void){
 }
 
 
+/**
+ * @brief  Fonction qui recalcule le Baud Rate (USART_BAUD) apres un changement d'horloge
+ * @param  uint32_t hz : frequence de PCLK
+ * @retval None
+ */
+void usart_horloge(uint32_t hz){
+	uint32_t actif = USART2->CR1 & USART_CR1_UE;
+	uint32_t usartdiv = (hz + USART_BAUD/2)/USART_BAUD;
+
+	//BRR ne s'ecrit que le USART desactive
+	USART2->CR1 &= ~USART_CR1_UE;
+	USART_CONFIG_BRR(USART2, usartdiv, 0);
+	USART2->CR1 |= actif;
+}
+
+
 void state_machine(control_struct_t *control){
 
 	//Si nous avons recue des donnees de la telecommande
@@ -91,6 +113,30 @@ void state_machine(control_struct_t *control){
 				//On passe au prochaine etat de la machine (Vitesse)
 				etat = VITESSE;
 			}
+			//Demande de vidage de l'enregistreur de vol (commande seule, sans vitesse ni angle)
+			else if(reception==0xF2){
+				enregistreur_demande_vidage();
+				etat = COMMANDE;
+			}
+			//Demande de la mesure de la pile et de la RAM (commande seule)
+			else if(reception==0xF3){
+				pile_demande_rapport();
+				etat = COMMANDE;
+			}
+			//Envoi d'une mission : les octets suivants vont a mission_recevoir
+			else if(reception==0xF4){
+				mission_debut_reception();
+				etat = MISSION;
+			}
+			//Depart et abandon de la mission (commandes seules)
+			else if(reception==0xF5){
+				mission_demarrer();
+				etat = COMMANDE;
+			}
+			else if(reception==0xF6){
+				mission_abandonner();
+				etat = COMMANDE;
+			}
 			//Si la commande recue n'est pas valide, on re-initialise la machine a etat
 			else{
 				etat = COMMANDE;
@@ -119,23 +165,29 @@ void state_machine(control_struct_t *control){
 				//On met a jour l'angle du robot
 				updateAngleUart(control,reception);
 				updateVitesse_angle(control);
+				liaison_trame_recue();
 			}
 			//Puisque l'angle est le dernier paquet recu, on re-initialise la machine a etat
 			etat = COMMANDE;
 
 			break;
+			//Liste d'etapes d'une mission, jusqu'a la somme de controle
+		case MISSION:
+			if(mission_recevoir(reception))
+				etat = COMMANDE;
+			break;
 
 		default:
 			break;
 		}
 		//On renvoie les donnes a la telecommande
-		USART2->CR1 |= USART_CR1_TXEIE;
-		if(counterDelay5ms>=10){
+		usart_demarrer_envoi();
+		if(counterDelay5ms>=MS_EN_TICKS(50)){
 			if(toggle_led_uart){
-				GPIO_SET(GPIOC,1);
+				BROCHE_SET(DEL_UART);
 				toggle_led_uart=0;
 			}else{
-				GPIO_RESET(GPIOC,1);
+				BROCHE_RESET(DEL_UART);
 				toggle_led_uart=1;
 			}
 			counterDelay5ms=0;
@@ -145,11 +197,30 @@ void state_machine(control_struct_t *control){
 }
 
 /**
- * @brief  La routine d'interuption du periherique USART
+ * @brief  Fonction qui active l'interruption de transmission pour envoyer
+ *         l'echo et les trames de telemetrie en attente
+ * @param  None
+ * @retval None
+ */
+void usart_demarrer_envoi(void){
+	USART2->CR1 |= USART_CR1_TXEIE;
+}
+
+/**
+ * @brief  Fonction qui indique si des octets recus attendent d'etre traites par state_machine
+ * @param  None
+ * @retval uint8_t : 1 si des octets sont en attente, 0 sinon
+ */
+uint8_t usart_reception_en_attente(void){
+	return buffer_count(&buffer_telecommande_reception)!=0;
+}
+
+/**
+ * @brief  La routine d'interuption du periherique USART (s'execute depuis la RAM)
  * @param  None
  * @retval None
  */
-void USART2_IRQHandler( void ){
+RAMFUNC void USART2_IRQHandler( void ){
 
 	//Cas d'une reception de donnee (RX)
 	if ( ( USART2->ISR & USART_ISR_RXNE ) == USART_ISR_RXNE ){
@@ -158,13 +229,18 @@ void USART2_IRQHandler( void ){
 	// Cas d'un envoi de donnee (TX)
 	else if ( ( USART2->ISR & USART_ISR_TXE ) == USART_ISR_TXE ){
 		uint8_t envoie;
-		if(buffer_count(&buffer_telecommande_envoie)!=0){
+		//Une trame de telemetrie commencee est finie avant de reprendre l'echo
+		int16_t octet = telemetrie_octet_suivant(buffer_count(&buffer_telecommande_envoie)==0);
+		if(octet>=0){
+			USART2->TDR = (uint16_t)octet;
+		}
+		else if(buffer_count(&buffer_telecommande_envoie)!=0){
 			buffer_pull(&buffer_telecommande_envoie, &envoie);
 			USART2->TDR = (uint16_t)envoie;
 		}
 		//Si nous avons fini de transcrire le contenue du buffer
-		//on transmet le tout
-		if(buffer_count(&buffer_telecommande_envoie)==0)
+		//et les trames on arrete l'interruption
+		else
 			USART2->CR1 &= ~USART_CR1_TXEIE;
 	}
 	/* S'il y une erreur de transmission on recommence */
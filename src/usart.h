@@ -17,10 +17,10 @@
 
 /* Defines -------------------------------------------------------------------*/
 #define USART_CONFIG_BRR(USART,USARTDIV,OVER8) USART->BRR=(USARTDIV & 0xFFF0)|((USARTDIV & 0x000F)>>OVER8)
-#define NICE 69
 #define COMMANDE 0
 #define VITESSE 1
 #define ANGLE 2
+#define MISSION 3
 
 /* Type definitions ----------------------------------------------------------*/
 
@@ -33,6 +33,13 @@
  */
 void config_uart2(void);
 
+/**
+ * @brief  Fonction qui recalcule le Baud Rate (USART_BAUD) apres un changement d'horloge
+ * @param  uint32_t hz : frequence de PCLK
+ * @retval None
+ */
+void usart_horloge(uint32_t hz);
+
 /**
  * @brief  	Fonction qui sert de machine a etat pour s'assurer de l'integrite du contenue recu le peripherique USART
  * 			Cette fonction envoie aussi un echo des donnees recue
@@ -41,6 +48,21 @@ void config_uart2(void);
  */
 void state_machine(control_struct_t *control);
 
+/**
+ * @brief  Fonction qui active l'interruption de transmission pour envoyer
+ *         l'echo et les trames de telemetrie en attente
+ * @param  None
+ * @retval None
+ */
+void usart_demarrer_envoi(void);
+
+/**
+ * @brief  Fonction qui indique si des octets recus attendent d'etre traites par state_machine
+ * @param  None
+ * @retval uint8_t : 1 si des octets sont en attente, 0 sinon
+ */
+uint8_t usart_reception_en_attente(void);
+
 
 
 #endif /* USART_H_ */
@@ -0,0 +1,67 @@
+/**
+ * @file        vecteurs.c
+ * @brief       Vector table in SRAM, so interrupt handlers can be swapped at runtime.
+ *
+ * @details     The Cortex-M0 has no VTOR: the core always fetches its
+ * vectors at address 0. On the F0, SYSCFG_CFGR1.MEM_MODE chooses what is
+ * mapped there. vecteurs_init() copies g_pfnVectors from the flash into the
+ * .ram_vector section, which the linker script places at the very start of
+ * the RAM, then maps the RAM at address 0. The section is NOLOAD: the startup
+ * code does not touch it and it is filled before any interrupt is enabled.
+ *
+ * A module can then install a different handler for each operating mode
+ * (for example calibration, run and low-power for the ADC) instead of
+ * testing the mode in the handler on every interrupt. Writing one vector is
+ * a single word store, so no masking is needed.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "vecteurs.h"
+
+/* Private variables ---------------------------------------------------------*/
+extern const uint32_t g_pfnVectors[VECTEURS_NB];	//table en flash (startup)
+
+//Placee a 0x20000000 par le linker script : c'est elle qui apparait a l'adresse 0
+static volatile uint32_t table[VECTEURS_NB] __attribute__((section(".ram_vector")));
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui copie la table des vecteurs de la flash au debut de la RAM et
+ *         place la RAM a l'adresse 0 (SYSCFG MEM_MODE). A appeler interruptions masquees,
+ *         avant l'installation des routines
+ * @param  None
+ * @retval None
+ */
+void vecteurs_init(void){
+	for(uint8_t i=0;i<VECTEURS_NB;i++)
+		table[i] = g_pfnVectors[i];
+
+	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+	SYSCFG->CFGR1 |= SYSCFG_CFGR1_MEM_MODE;		// 11 : SRAM a l'adresse 0
+	__DSB();
+	__ISB();
+}
+
+/**
+ * @brief  Fonction qui remplace la routine d'une interruption dans la table en RAM
+ * @param  IRQn_Type irq : interruption du peripherique (ADC1_COMP_IRQn, ...)
+ *         vecteur_t routine : nouvelle routine
+ * @retval None
+ */
+void vecteurs_installer(IRQn_Type irq, vecteur_t routine){
+	table[VECTEURS_EXCEPTIONS + (int32_t)irq] = (uint32_t)(uintptr_t)routine;
+	__DSB();	// l'ecriture est terminee avant la prochaine entree dans l'interruption
+}
+
+/**
+ * @brief  accesseur de la routine installee pour une interruption
+ * @param  IRQn_Type irq : interruption du peripherique
+ * @retval vecteur_t : routine appelee par le NVIC
+ */
+vecteur_t pull_vecteur(IRQn_Type irq){
+	return (vecteur_t)(uintptr_t)table[VECTEURS_EXCEPTIONS + (int32_t)irq];
+}
@@ -0,0 +1,49 @@
+/**
+ ******************************************************************************
+ * File Name          : vecteurs.h
+ * Description        : ce module copie la table des vecteurs en RAM et permet de changer
+ * 						les routines d'interruption pendant l'execution
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef VECTEURS_H_
+#define VECTEURS_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+/* Defines -------------------------------------------------------------------*/
+#define VECTEURS_EXCEPTIONS 	16		//exceptions du Cortex-M0 avant la premiere IRQ
+#define VECTEURS_NB 			(VECTEURS_EXCEPTIONS + 32)	//taille de g_pfnVectors
+
+/* Type definitions ----------------------------------------------------------*/
+typedef void (*vecteur_t)(void);
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui copie la table des vecteurs de la flash au debut de la RAM et
+ *         place la RAM a l'adresse 0 (SYSCFG MEM_MODE). A appeler interruptions masquees,
+ *         avant l'installation des routines
+ * @param  None
+ * @retval None
+ */
+void vecteurs_init(void);
+
+/**
+ * @brief  Fonction qui remplace la routine d'une interruption dans la table en RAM
+ * @param  IRQn_Type irq : interruption du peripherique (ADC1_COMP_IRQn, ...)
+ *         vecteur_t routine : nouvelle routine
+ * @retval None
+ */
+void vecteurs_installer(IRQn_Type irq, vecteur_t routine);
+
+/**
+ * @brief  accesseur de la routine installee pour une interruption
+ * @param  IRQn_Type irq : interruption du peripherique
+ * @retval vecteur_t : routine appelee par le NVIC
+ */
+vecteur_t pull_vecteur(IRQn_Type irq);
+
+#endif /* VECTEURS_H_ */
@@ -0,0 +1,103 @@
+/**
+ * @file        veille.c
+ * @brief       Low-power state while the robot is e-stopped.
+ *
+ * @details     On entering the e-stop, the core drops to HORLOGE_BASSE_HZ.
+ * The ADC stops converting and is disabled, and the ADC and I2C clocks are
+ * gated. The sonar is not pinged while stopped. Between control ticks, the
+ * main loop sleeps with WFI. SysTick, the start button (EXTI0) and the
+ * USART2 receiver wake it up, so the remote link, the debounce and the
+ * watchdog keep running.
+ *
+ * Stop mode is not used. USART2 cannot wake the F051 from Stop, and the
+ * IWDG keeps counting while nothing would refresh it.
+ *
+ * On restart, the ADC is calibrated and started again at the low
+ * frequency, then the clock goes back to HCLK_HZ. Every step has a
+ * timeout. The measured duration is reported in the telemetry.
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "veille.h"
+#include "horloge.h"
+#include "adc.h"
+#include "usart.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t en_veille = 0;
+static uint16_t reveil_us = 0;
+
+/* Public functions  ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui met le robot en veille : arrete l'ADC, coupe l'horloge du I2C
+ *         et reduit la frequence a HORLOGE_BASSE_HZ (a l'entree en arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void veille_entrer(void){
+	if(en_veille)
+		return;
+
+	//Le TIMINGR du I2C est recalcule par horloge_changer : on coupe son horloge apres
+	horloge_changer(HORLOGE_BASSE_HZ);
+	adc_suspendre();
+	RCC->APB1ENR &= ~RCC_APB1ENR_I2C1EN;
+	en_veille = 1;
+}
+
+/**
+ * @brief  Fonction qui remet le robot en fonctionnement complet et mesure la duree de la reprise
+ *         (a la remise en marche)
+ * @param  None
+ * @retval uint8_t : 1 si le robot peut rouler, 0 si l'ADC n'a pas redemarre (il reste en veille)
+ */
+uint8_t veille_sortir(void){
+	uint32_t debut, cycles;
+	uint32_t frequence = pull_horloge_hz();
+
+	if(!en_veille)
+		return 1;
+
+	debut = SysTick->VAL;
+	if(!adc_reprendre()){
+		//Sans ADC : ni mesure de vitesse, ni surcourant, ni blocage. On reste en veille
+		return 0;
+	}
+	RCC->APB1ENR |= RCC_APB1ENR_I2C1EN;	//avant horloge_changer, qui recalcule le TIMINGR
+	cycles = systick_cycles_depuis(debut);
+
+	horloge_changer(HCLK_HZ);
+	reveil_us = (uint16_t)(cycles/(frequence/1000000UL)) + pull_horloge_duree_us();
+	en_veille = 0;
+	return 1;
+}
+
+/**
+ * @brief  Fonction qui endort le coeur (WFI) jusqu'a la prochaine interruption si le robot est
+ *         en veille et qu'aucun travail n'attend (a appeler a chaque tour de la boucle principale)
+ * @param  None
+ * @retval None
+ */
+void veille_attendre(void){
+	if(!en_veille)
+		return;
+
+	//Interruptions masquees : une interruption arrivee apres le test reveille quand meme le WFI
+	__disable_irq();
+	if(!interup_5ms && !usart_reception_en_attente())
+		__WFI();
+	__enable_irq();
+}
+
+/**
+ * @brief  accesseur de la duree de la derniere sortie de veille
+ * @param  None
+ * @retval uint16_t : duree (us)
+ */
+uint16_t pull_veille_reveil_us(void){
+	return reveil_us;
+}
@@ -0,0 +1,51 @@
+/**
+ ******************************************************************************
+ * File Name          : veille.h
+ * Description        : ce module gere la mise en veille du robot pendant l'arret d'urgence
+ * 						(ADC et I2C coupes, frequence reduite, mode Sleep entre les ticks)
+ * Created            : Jun 2022
+ * Author             : Thomas Giguere Sturrock
+ ******************************************************************************
+ */
+
+/* Prevent recursive inclusion -----------------------------------------------*/
+#ifndef VEILLE_H_
+#define VEILLE_H_
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+/* Defines -------------------------------------------------------------------*/
+
+/* Function prototypes ------------------------------------------------------ */
+
+/**
+ * @brief  Fonction qui met le robot en veille : arrete l'ADC, coupe l'horloge du I2C
+ *         et reduit la frequence a HORLOGE_BASSE_HZ (a l'entree en arret d'urgence)
+ * @param  None
+ * @retval None
+ */
+void veille_entrer(void);
+
+/**
+ * @brief  Fonction qui remet le robot en fonctionnement complet et mesure la duree de la reprise
+ *         (a la remise en marche)
+ * @param  None
+ * @retval uint8_t : 1 si le robot peut rouler, 0 si l'ADC n'a pas redemarre (il reste en veille)
+ */
+uint8_t veille_sortir(void);
+
+/**
+ * @brief  Fonction qui endort le coeur (WFI) jusqu'a la prochaine interruption si le robot est
+ *         en veille et qu'aucun travail n'attend (a appeler a chaque tour de la boucle principale)
+ * @param  None
+ * @retval None
+ */
+void veille_attendre(void);
+
+/**
+ * @brief  accesseur de la duree de la derniere sortie de veille
+ * @param  None
+ * @retval uint16_t : duree (us)
+ */
+uint16_t pull_veille_reveil_us(void);
+
+#endif /* VEILLE_H_ */
@@ -0,0 +1,345 @@
+/**
+ * @file        balayage_gains.c
+ * @brief       Host tool that sweeps the controller gains against a plant model.
+ *
+ * @details     Runs the firmware controller (ControleurPWM_Pas, compiled
+ * from ../src/moteur.c) in closed loop with a model of the robot: each
+ * wheel is a first-order lag of time constant Tau from duty to speed.
+ * Every candidate set of gains (H11, H12, H21, H22) drives the same
+ * maneuver: a step of the commanded speed and of the commanded heading at
+ * the same time. The run is scored on four objectives, all to minimize:
+ * - settling time: last time the speed or the heading is outside its band;
+ * - overshoot: largest overshoot of the speed or of the heading (% of step);
+ * - heading error: integral of the absolute heading error (rad.s);
+ * - saturation time: time with a duty at the 0.99 limit.
+ *
+ * The candidates are a log-spaced grid around the moteur.h gains, or a
+ * random sample in the same range. They are spread across the cores by a
+ * pool of threads that take the next candidate from a shared atomic index.
+ * The output is the candidates ranked by the sum of their objectives
+ * normalized by those of the moteur.h gains (which score at most 4, an
+ * objective where they are near zero is normalized by a floor), then the
+ * Pareto front (candidates that no other one beats on every objective).
+ *
+ * Usage : balayage_gains [-j threads] [-n points] [-a echantillons] [-e etendue]
+ *                        [-s graine] [-t tau] [-k rangs]
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../src/moteur.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define DUREE_S 			4.0			//duree de la manoeuvre simulee
+#define VITESSE_CONSIGNE 	0.5			//echelon de vitesse (pleine echelle = 1)
+#define ANGLE_CONSIGNE 		(Pi/2.0)	//echelon de cap (rad)
+#define BANDE_VITESSE 		0.05		//bande d'etablissement (fraction de l'echelon)
+#define BANDE_ANGLE 		0.05		//au-dela de la zone morte de Ua (0.05/H21 rad)
+#define DUTY_SATURE 		0.989		//CalculPWM limite les duty a 0.99
+#define NB_OBJECTIFS 		4
+#define THREADS_MAX 		256
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct {
+	GainsPWM_t gains;
+	double objectif[NB_OBJECTIFS];	//etablissement (s), depassement (%), erreur de cap (rad.s), saturation (s)
+	double note;					//somme des objectifs normalises par ceux des gains de moteur.h
+} candidat_t;
+
+typedef struct {
+	candidat_t *candidats;
+	size_t nombre;
+	atomic_size_t suivant;			//prochain candidat a simuler
+	double tau;
+} travail_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const char *nom_objectif[NB_OBJECTIFS] = { "etabli_s", "depasse_%", "erreur_rad_s", "sature_s" };
+static const double plancher[NB_OBJECTIFS] = { TS, 1.0, 0.01, TS };	//normalisation minimale de chaque objectif
+
+/* Private function prototypes -----------------------------------------------*/
+static void simuler(candidat_t *candidat, double tau);
+static void *ouvrier(void *argument);
+static double aleatoire(uint64_t *etat);
+static double noter(const candidat_t *candidat, const double *echelle);
+static int comparer_note(const void *a, const void *b);
+static int comparer_objectifs(const void *a, const void *b);
+static int domine(const candidat_t *a, const candidat_t *b);
+static void ecrire_candidat(const candidat_t *candidat);
+static void usage(void);
+
+/* Public functions  ---------------------------------------------------------*/
+int main(int argc, char **argv){
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned long points = 9, echantillons = 0, rangs = 20;
+	double etendue = 4.0, tau = Tau;
+	uint64_t graine = 1;
+	const GainsPWM_t defaut = GAINS_PWM_DEFAUT;
+	candidat_t reference;
+	double echelle[NB_OBJECTIFS];
+	candidat_t *candidats, **front;
+	size_t nombre, nb_front = 0;
+	pthread_t pool[THREADS_MAX];
+	travail_t travail;
+	int option;
+
+	while((option = getopt(argc, argv, "j:n:a:e:s:t:k:h")) != -1){
+		switch(option){
+		case 'j': threads = strtol(optarg, NULL, 0); break;
+		case 'n': points = strtoul(optarg, NULL, 0); break;
+		case 'a': echantillons = strtoul(optarg, NULL, 0); break;
+		case 'e': etendue = strtod(optarg, NULL); break;
+		case 's': graine = strtoull(optarg, NULL, 0); break;
+		case 't': tau = strtod(optarg, NULL); break;
+		case 'k': rangs = strtoul(optarg, NULL, 0); break;
+		default: usage(); return 1;
+		}
+	}
+	if(threads < 1)
+		threads = 1;
+	if(threads > THREADS_MAX)
+		threads = THREADS_MAX;
+	if(points < 1 || etendue < 1.0 || tau <= 0.0 || graine == 0){
+		usage();
+		return 1;
+	}
+
+	//Candidats : grille log de defaut/etendue a defaut*etendue sur chaque gain, ou tirage aleatoire
+	nombre = echantillons ? echantillons : points*points*points*points;
+	candidats = calloc(nombre, sizeof(candidat_t));
+	front = calloc(nombre, sizeof(candidat_t *));
+	if(candidats == NULL || front == NULL){
+		fprintf(stderr, "memoire insuffisante pour %zu candidats\n", nombre);
+		return 1;
+	}
+	for(size_t i=0;i<nombre;i++){
+		double facteur[4];
+		size_t reste = i;
+		for(int g=0;g<4;g++){
+			double x;
+			if(echantillons){
+				x = aleatoire(&graine);
+			}else{
+				x = (points > 1) ? (double)(reste % points)/(double)(points - 1) : 0.5;
+				reste /= points;
+			}
+			facteur[g] = pow(etendue, 2.0*x - 1.0);
+		}
+		candidats[i].gains.h11 = (float)(defaut.h11*facteur[0]);
+		candidats[i].gains.h12 = (float)(defaut.h12*facteur[1]);
+		candidats[i].gains.h21 = (float)(defaut.h21*facteur[2]);
+		candidats[i].gains.h22 = (float)(defaut.h22*facteur[3]);
+	}
+
+	reference.gains = defaut;
+	simuler(&reference, tau);
+
+	travail.candidats = candidats;
+	travail.nombre = nombre;
+	travail.tau = tau;
+	atomic_init(&travail.suivant, 0);
+	for(long t=0;t<threads;t++){
+		if(pthread_create(&pool[t], NULL, ouvrier, &travail) != 0){
+			threads = t;
+			break;
+		}
+	}
+	if(threads == 0)
+		ouvrier(&travail);
+	for(long t=0;t<threads;t++)
+		pthread_join(pool[t], NULL);
+
+	//Note : somme des objectifs normalises par ceux des gains de moteur.h (au moins le plancher)
+	for(int o=0;o<NB_OBJECTIFS;o++)
+		echelle[o] = (reference.objectif[o] > plancher[o]) ? reference.objectif[o] : plancher[o];
+	for(size_t i=0;i<nombre;i++)
+		candidats[i].note = noter(&candidats[i], echelle);
+	reference.note = noter(&reference, echelle);
+
+	printf("%zu candidats, %ld threads, tau %.3f s\n\n", nombre, threads ? threads : 1, tau);
+	printf("%4s %9s %9s %9s %9s", "rang", "H11", "H12", "H21", "H22");
+	for(int o=0;o<NB_OBJECTIFS;o++)
+		printf(" %12s", nom_objectif[o]);
+	printf(" %8s\n", "note");
+	printf("%4s ", "ref");
+	ecrire_candidat(&reference);
+
+	qsort(candidats, nombre, sizeof(candidat_t), comparer_note);
+	for(size_t i=0;i<nombre && i<rangs;i++){
+		printf("%4zu ", i + 1);
+		ecrire_candidat(&candidats[i]);
+	}
+
+	//Front de Pareto : en ordre lexicographique, un candidat ne peut etre domine que par un
+	//candidat qui le precede, et il suffit de le comparer au front deja trouve
+	qsort(candidats, nombre, sizeof(candidat_t), comparer_objectifs);
+	for(size_t i=0;i<nombre;i++){
+		size_t f;
+		for(f=0;f<nb_front;f++){
+			if(domine(front[f], &candidats[i]))
+				break;
+		}
+		if(f == nb_front)
+			front[nb_front++] = &candidats[i];
+	}
+	printf("\nfront de Pareto : %zu candidats\n", nb_front);
+	for(size_t f=0;f<nb_front;f++){
+		printf("%4s ", "");
+		ecrire_candidat(front[f]);
+	}
+
+	free(front);
+	free(candidats);
+	return 0;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui simule la manoeuvre avec les gains d'un candidat et calcule ses objectifs
+ * @param  candidat_t *candidat : candidat a simuler (gains en entree, objectifs en sortie)
+ *         double tau : constante de temps des roues (s)
+ * @retval None
+ */
+static void simuler(candidat_t *candidat, double tau){
+	ControleurPWM_t controleur;
+	unsigned long pas = (unsigned long)(DUREE_S/TS + 0.5);
+	double alpha = TS/tau;
+	double vg = 0, vd = 0;
+	double depasse_vitesse = 0, depasse_angle = 0;
+	double erreur = 0, sature = 0, etabli = 0;
+
+	ControleurPWM_Init(&controleur, &candidat->gains);
+	for(unsigned long k=0;k<pas;k++){
+		float duty_g, duty_d;
+		double angle, ecart;
+
+		ControleurPWM_Pas(&controleur, (float)VITESSE_CONSIGNE, (float)ANGLE_CONSIGNE, (float)vg, (float)vd, &duty_g, &duty_d);
+
+		//Roues : premier ordre du duty a la vitesse
+		vg += alpha*(duty_g - vg);
+		vd += alpha*(duty_d - vd);
+
+		//Le cap est celui que l'asservissement integre, ramene entre -pi et pi
+		angle = controleur.Angle;
+		if(angle > Pi)
+			angle -= 2*Pi;
+		ecart = angle - ANGLE_CONSIGNE;
+
+		erreur += fabs(ecart)*TS;
+		if(fabs(duty_g) >= DUTY_SATURE || fabs(duty_d) >= DUTY_SATURE)
+			sature += TS;
+		if(controleur.Vt - VITESSE_CONSIGNE > depasse_vitesse)
+			depasse_vitesse = controleur.Vt - VITESSE_CONSIGNE;
+		if(ecart > depasse_angle)
+			depasse_angle = ecart;
+		if(fabs(controleur.Vt - VITESSE_CONSIGNE) > BANDE_VITESSE*VITESSE_CONSIGNE
+				|| fabs(ecart) > BANDE_ANGLE*ANGLE_CONSIGNE)
+			etabli = (double)(k + 1)*TS;
+	}
+
+	candidat->objectif[0] = etabli;
+	depasse_vitesse *= 100.0/VITESSE_CONSIGNE;
+	depasse_angle *= 100.0/ANGLE_CONSIGNE;
+	candidat->objectif[1] = (depasse_vitesse > depasse_angle) ? depasse_vitesse : depasse_angle;
+	candidat->objectif[2] = erreur;
+	candidat->objectif[3] = sature;
+}
+
+/**
+ * @brief  Fonction d'un thread du pool : simule les candidats jusqu'a ce qu'il n'en reste plus
+ * @param  void *argument : travail_t partage
+ * @retval void * : NULL
+ */
+static void *ouvrier(void *argument){
+	travail_t *travail = argument;
+	size_t i;
+
+	while((i = atomic_fetch_add_explicit(&travail->suivant, 1, memory_order_relaxed)) < travail->nombre)
+		simuler(&travail->candidats[i], travail->tau);
+	return NULL;
+}
+
+/**
+ * @brief  Fonction qui tire un nombre pseudo-aleatoire (xorshift64*), reproductible avec la graine
+ * @param  uint64_t *etat : etat du generateur (non nul)
+ * @retval double : nombre entre 0 et 1
+ */
+static double aleatoire(uint64_t *etat){
+	*etat ^= *etat >> 12;
+	*etat ^= *etat << 25;
+	*etat ^= *etat >> 27;
+	return (double)((*etat*0x2545F4914F6CDD1DULL) >> 11)/9007199254740992.0;
+}
+
+/**
+ * @brief  Fonction qui note un candidat : somme de ses objectifs normalises
+ * @param  const candidat_t *candidat : candidat simule
+ *         const double *echelle : normalisation de chaque objectif
+ * @retval double : note, plus petite est meilleure
+ */
+static double noter(const candidat_t *candidat, const double *echelle){
+	double note = 0;
+	for(int o=0;o<NB_OBJECTIFS;o++)
+		note += candidat->objectif[o]/echelle[o];
+	return note;
+}
+
+/**
+ * @brief  Fonction de tri par note croissante
+ */
+static int comparer_note(const void *a, const void *b){
+	double na = ((const candidat_t *)a)->note, nb = ((const candidat_t *)b)->note;
+	return (na > nb) - (na < nb);
+}
+
+/**
+ * @brief  Fonction de tri lexicographique des objectifs
+ */
+static int comparer_objectifs(const void *a, const void *b){
+	const candidat_t *ca = a, *cb = b;
+	for(int o=0;o<NB_OBJECTIFS;o++){
+		if(ca->objectif[o] != cb->objectif[o])
+			return (ca->objectif[o] > cb->objectif[o]) - (ca->objectif[o] < cb->objectif[o]);
+	}
+	return 0;
+}
+
+/**
+ * @brief  Fonction qui verifie si un candidat en domine un autre (pas pire sur tous les
+ *         objectifs, meilleur sur au moins un)
+ * @param  const candidat_t *a, *b : candidats
+ * @retval int : 1 si a domine b
+ */
+static int domine(const candidat_t *a, const candidat_t *b){
+	int meilleur = 0;
+	for(int o=0;o<NB_OBJECTIFS;o++){
+		if(a->objectif[o] > b->objectif[o])
+			return 0;
+		if(a->objectif[o] < b->objectif[o])
+			meilleur = 1;
+	}
+	return meilleur;
+}
+
+static void ecrire_candidat(const candidat_t *candidat){
+	printf("%9.4f %9.4f %9.4f %9.4f", candidat->gains.h11, candidat->gains.h12, candidat->gains.h21, candidat->gains.h22);
+	for(int o=0;o<NB_OBJECTIFS;o++)
+		printf(" %12.4f", candidat->objectif[o]);
+	printf(" %8.3f\n", candidat->note);
+}
+
+static void usage(void){
+	fprintf(stderr, "usage : balayage_gains [-j threads] [-n points par gain] [-a echantillons aleatoires]\n"
+			"                       [-e etendue (facteur autour de moteur.h)] [-s graine] [-t tau (s)] [-k rangs]\n");
+}
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+@file        ram_rapport.py
+@brief       Host tool that breaks down the static RAM budget per module.
+
+@details     Reads the GNU ld map file produced by the firmware link (for
+Atollic TrueSTUDIO, Debug/<projet>.map) and sums the .ram_vector, .data, .bss
+and .noinit input sections of each object file. It also reads the heap and stack reserved
+by the linker script (_Min_Heap_Size, _Min_Stack_Size) and prints what is
+left of the RAM. The real stack high-water mark is measured on the robot
+(command 0xF3, pile.c).
+
+Usage : ram_rapport.py ../Debug/Proto1.map [--ram 8192]
+
+@author      Thomas Giguere Sturrock
+@date        Jun 2022
+"""
+
+import argparse
+import os
+import re
+import sys
+
+RAM_DEBUT = 0x20000000
+
+# Sections de sortie du linker script qui occupent la RAM
+SECTIONS_RAM = ('.ram_vector', '.data', '.bss', '.noinit')
+
+SECTION_SORTIE = re.compile(r'^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?')
+SECTION_ENTREE = re.compile(r'^ (\S+|\*fill\*)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(.+))?$')
+NOM_SEUL = re.compile(r'^ (\S+)$')
+SYMBOLE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+(_Min_Heap_Size|_Min_Stack_Size)\s*=')
+
+
+def nom_module(fichier):
+    """Nom court d'un objet : main.o, ou libc.a(lib_a-sprintf.o) pour une archive"""
+    if fichier is None:
+        return '(remplissage)'
+    archive = re.match(r'(.*\.a)\((.*)\)$', fichier)
+    if archive:
+        return '%s(%s)' % (os.path.basename(archive.group(1)), archive.group(2))
+    return os.path.basename(fichier)
+
+
+def lire_carte(chemin):
+    """Retourne ({module: {section: octets}}, {symbole: valeur})"""
+    modules = {}
+    symboles = {}
+    sortie = None
+    en_attente = None
+    dans_carte = False
+
+    with open(chemin, encoding='latin-1') as carte:
+        for ligne in carte:
+            ligne = ligne.rstrip()
+
+            if ligne.startswith('Linker script and memory map'):
+                dans_carte = True
+                continue
+            if not dans_carte:
+                continue
+
+            symbole = SYMBOLE.match(ligne)
+            if symbole:
+                symboles[symbole.group(2)] = int(symbole.group(1), 16)
+                continue
+
+            # Section de sortie (commence en colonne 0)
+            if ligne.startswith('.'):
+                m = SECTION_SORTIE.match(ligne)
+                sortie = m.group(1) if m and m.group(1) in SECTIONS_RAM else None
+                en_attente = None
+                continue
+
+            if sortie is None:
+                continue
+
+            # Un nom de section d'entree trop long est seul sur sa ligne
+            m = NOM_SEUL.match(ligne)
+            if m and not ligne.startswith(' *('):
+                en_attente = m.group(1)
+                continue
+
+            m = SECTION_ENTREE.match(ligne)
+            if m:
+                nom = m.group(1) or en_attente
+                en_attente = None
+                if nom is None:
+                    continue
+                adresse = int(m.group(2), 16)
+                taille = int(m.group(3), 16)
+                if taille == 0 or adresse < RAM_DEBUT:
+                    continue
+                fichier = None if nom == '*fill*' else m.group(4)
+                if fichier is not None and ' ' in fichier.strip():
+                    continue  # une affectation de symbole, pas une section
+                module = modules.setdefault(nom_module(fichier), {})
+                module[sortie] = module.get(sortie, 0) + taille
+
+    return modules, symboles
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Occupation statique de la RAM par module")
+    parser.add_argument('carte', help="fichier .map du linker")
+    parser.add_argument('--ram', type=int, default=8 * 1024, help="taille de la RAM (octets)")
+    args = parser.parse_args()
+
+    modules, symboles = lire_carte(args.carte)
+    if not modules:
+        print("aucune section .ram_vector/.data/.bss/.noinit trouvee dans %s" % args.carte, file=sys.stderr)
+        return 1
+
+    print('%-32s' % 'module' + ''.join(' %11s' % section for section in SECTIONS_RAM) + ' %8s' % 'total')
+    totaux = dict.fromkeys(SECTIONS_RAM, 0)
+    for nom, sections in sorted(modules.items(), key=lambda m: -sum(m[1].values())):
+        for section in SECTIONS_RAM:
+            totaux[section] += sections.get(section, 0)
+        print('%-32s' % nom + ''.join(' %11d' % sections.get(section, 0) for section in SECTIONS_RAM)
+              + ' %8d' % sum(sections.values()))
+
+    statique = sum(totaux.values())
+    tas = symboles.get('_Min_Heap_Size', 0)
+    pile = symboles.get('_Min_Stack_Size', 0)
+    print('%-32s' % 'total' + ''.join(' %11d' % totaux[section] for section in SECTIONS_RAM) + ' %8d' % statique)
+    print()
+    print('RAM                  %6d' % args.ram)
+    print('donnees statiques    %6d' % statique)
+    print('tas (_Min_Heap_Size) %6d' % tas)
+    print('pile reservee        %6d  (_Min_Stack_Size, a comparer au niveau maximal mesure)' % pile)
+    print('libre pour la pile   %6d  (entre les donnees statiques et _estack)' % (args.ram - statique - tas))
+    print('libre apres reserve  %6d' % (args.ram - statique - tas - pile))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
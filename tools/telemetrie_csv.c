@@ -0,0 +1,226 @@
+/**
+ * @file        telemetrie_csv.c
+ * @brief       Host tool that decodes the robot's USART2 telemetry to CSV.
+ *
+ * @details     Reads a raw capture of the serial link (file or stdin) and
+ * writes one CSV line per valid telemetry record on stdout. The stream
+ * also carries the echo of the remote control, so the decoder resyncs on
+ * TRAME_SYNC_1/TRAME_SYNC_2 and drops frames whose checksum is wrong.
+ * After a bad length or checksum only the first sync byte is dropped: the
+ * rest of the candidate is scanned again, so a real frame that started
+ * inside it is not lost.
+ * Flight recorder dumps (TRAME_ENREGISTREUR) are written to a second CSV
+ * when its name is given. The HardFault report (TRAME_FAUTE) and the
+ * reset cause (TRAME_DEMARRAGE), the RAM usage (TRAME_PILE) and the
+ * mission events (TRAME_MISSION) are printed on stderr.
+ *
+ * Usage : telemetrie_csv [capture.bin [enregistreur.csv]] > telemetrie.csv
+ *
+ * @author      Thomas Giguere Sturrock
+ * @date        Jun 2022
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "../src/telemetrie_trame.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t relecture[TRAME_TAILLE_MAX];	//octets d'une trame rejetee a analyser de nouveau
+static unsigned int relus = 0;
+static unsigned int a_relire = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static int lire(FILE *entree);
+static void rejeter(const uint8_t *trame, unsigned int position);
+static void ecrire_telemetrie(const uint8_t *donnees);
+static void ecrire_enregistreur(FILE *sortie, const uint8_t *donnees);
+static void ecrire_faute(const uint8_t *donnees);
+static void ecrire_demarrage(const uint8_t *donnees);
+static void ecrire_pile(const uint8_t *donnees);
+static void ecrire_mission(const uint8_t *donnees);
+
+/* Public functions  ---------------------------------------------------------*/
+int main(int argc, char **argv){
+	FILE *entree = stdin;
+	FILE *enregistreur = NULL;
+	uint8_t trame[TRAME_TAILLE_MAX];
+	unsigned int position = 0;
+	unsigned long invalides = 0;
+	int c;
+
+	if(argc > 1){
+		entree = fopen(argv[1], "rb");
+		if(entree == NULL){
+			perror(argv[1]);
+			return 1;
+		}
+	}
+	if(argc > 2){
+		enregistreur = fopen(argv[2], "w");
+		if(enregistreur == NULL){
+			perror(argv[2]);
+			return 1;
+		}
+		fprintf(enregistreur, "index,nombre,cause,tick,vitesse,angle_mrad,v_moyenne_gauche,v_moyenne_droite,"
+				"duty_gauche,duty_droite,angle_estime_mrad,w_mrad_s,sonar_gauche_cm,sonar_droit_cm,"
+				"sonar_g,sonar_d,arret_urgence,surcourant,blocage,commande\n");
+	}
+
+	printf("sequence,vitesse,angle_mrad,v_moyenne_gauche,v_moyenne_droite,"
+			"duty_gauche,duty_droite,sonar_gauche_cm,sonar_droit_cm,"
+			"sonar_g,sonar_d,arret_urgence,surcourant,blocage,depassement,"
+			"perdues,duree_boucle_us,duree_max_us,reveil_us,exec_ram,cycles_controle,cycles_adc,ttc_gauche_ms,ttc_droit_ms,x_mm,y_mm,theta_mrad,mission,liaison_trames_s,liaison_pertes,liaison_etat,liaison_silence_ms\n");
+
+	while((c = lire(entree)) != EOF){
+		trame[position++] = (uint8_t)c;
+
+		//Recherche de la synchronisation
+		if(position == 1 && trame[0] != TRAME_SYNC_1){
+			position = 0;
+			continue;
+		}
+		if(position == 2 && trame[1] != TRAME_SYNC_2){
+			position = (trame[1] == TRAME_SYNC_1) ? 1 : 0;
+			trame[0] = trame[1];
+			continue;
+		}
+		if(position == TRAME_ENTETE && trame[3] > TRAME_DONNEES_MAX){
+			invalides++;
+			rejeter(trame, position);
+			position = 0;
+			continue;
+		}
+		if(position < TRAME_ENTETE || position < (unsigned int)(TRAME_ENTETE + trame[3] + 1))
+			continue;
+
+		uint8_t somme = 0;
+		for(unsigned int i = 2; i < position - 1; i++)
+			somme += trame[i];
+
+		if(somme != trame[position - 1]){
+			invalides++;
+			rejeter(trame, position);
+		}else if(trame[2] == TRAME_TELEMETRIE && trame[3] == sizeof(trame_telemetrie_t)){
+			ecrire_telemetrie(&trame[TRAME_ENTETE]);
+		}else if(trame[2] == TRAME_ENREGISTREUR && trame[3] == sizeof(trame_enregistreur_t) && enregistreur){
+			ecrire_enregistreur(enregistreur, &trame[TRAME_ENTETE]);
+		}else if(trame[2] == TRAME_FAUTE && trame[3] == sizeof(trame_faute_t)){
+			ecrire_faute(&trame[TRAME_ENTETE]);
+		}else if(trame[2] == TRAME_DEMARRAGE && trame[3] == sizeof(trame_demarrage_t)){
+			ecrire_demarrage(&trame[TRAME_ENTETE]);
+		}else if(trame[2] == TRAME_PILE && trame[3] == sizeof(trame_pile_t)){
+			ecrire_pile(&trame[TRAME_ENTETE]);
+		}else if(trame[2] == TRAME_MISSION && trame[3] == sizeof(trame_mission_t)){
+			ecrire_mission(&trame[TRAME_ENTETE]);
+		}
+		position = 0;
+	}
+
+	if(invalides)
+		fprintf(stderr, "%lu trames invalides\n", invalides);
+	if(entree != stdin)
+		fclose(entree);
+	if(enregistreur)
+		fclose(enregistreur);
+	return 0;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Fonction qui lit le prochain octet : d'abord ceux d'une trame rejetee, puis l'entree
+ * @param  FILE *entree : capture
+ * @retval int : octet, ou EOF
+ */
+static int lire(FILE *entree){
+	if(relus < a_relire)
+		return relecture[relus++];
+	return fgetc(entree);
+}
+
+/**
+ * @brief  Fonction qui remet les octets d'une trame rejetee, sauf le premier, devant ceux qui
+ *         restent a relire : la synchronisation est cherchee de nouveau un octet plus loin
+ * @param  const uint8_t *trame : trame rejetee
+ *         unsigned int position : nb d'octets de la trame
+ * @retval None
+ */
+static void rejeter(const uint8_t *trame, unsigned int position){
+	unsigned int reste = a_relire - relus;
+
+	//Tous ces octets viennent de la premiere trame rejetee : ils tiennent dans TRAME_TAILLE_MAX
+	memmove(&relecture[position - 1], &relecture[relus], reste);
+	memcpy(relecture, &trame[1], position - 1);
+	a_relire = position - 1 + reste;
+	relus = 0;
+}
+
+static void ecrire_telemetrie(const uint8_t *donnees){
+	trame_telemetrie_t t;
+	memcpy(&t, donnees, sizeof(t));
+
+	printf("%u,%d,%d,%d,%d,%d,%d,%u,%u,%d,%d,%d,%d,%d,%d,%u,%u,%u,%u,%d,%u,%u,%u,%u,%d,%d,%d,%d,%u,%u,%u,%u\n",
+			t.sequence, t.vitesse, t.angle, t.v_moyenne_gauche, t.v_moyenne_droite,
+			t.duty_gauche, t.duty_droite, t.sonar_gauche, t.sonar_droit,
+			!!(t.drapeaux & TELEM_SONAR_GAUCHE), !!(t.drapeaux & TELEM_SONAR_DROIT),
+			!!(t.drapeaux & TELEM_ARRET_URGENCE), !!(t.drapeaux & TELEM_SURCOURANT),
+			!!(t.drapeaux & TELEM_BLOCAGE), !!(t.drapeaux & TELEM_DEPASSEMENT),
+			t.perdues, t.duree_boucle, t.duree_max, t.reveil,
+			!!(t.drapeaux & TELEM_EXEC_RAM), t.cycles_controle, t.cycles_adc, t.ttc_gauche, t.ttc_droit,
+			t.x, t.y, t.theta, !!(t.drapeaux & TELEM_MISSION),
+			t.liaison_debit, t.liaison_pertes, t.liaison_etat, t.liaison_silence);
+}
+static void ecrire_enregistreur(FILE *sortie, const uint8_t *donnees){
+	trame_enregistreur_t t;
+	memcpy(&t, donnees, sizeof(t));
+
+	fprintf(sortie, "%u,%u,%u,%u,%d,%d,%d,%d,%d,%d,%d,%d,%u,%u,%d,%d,%d,%d,%d,0x%02X\n",
+			t.index, t.nombre, t.cause, t.entree.tick, t.entree.vitesse, t.entree.angle,
+			t.entree.v_moyenne_gauche, t.entree.v_moyenne_droite,
+			t.entree.duty_gauche, t.entree.duty_droite, t.entree.angle_estime, t.entree.w,
+			t.entree.sonar_gauche, t.entree.sonar_droit,
+			!!(t.entree.drapeaux & TELEM_SONAR_GAUCHE), !!(t.entree.drapeaux & TELEM_SONAR_DROIT),
+			!!(t.entree.drapeaux & TELEM_ARRET_URGENCE), !!(t.entree.drapeaux & TELEM_SURCOURANT),
+			!!(t.entree.drapeaux & TELEM_BLOCAGE), t.entree.commande);
+}
+static void ecrire_faute(const uint8_t *donnees){
+	trame_faute_t t;
+	memcpy(&t, donnees, sizeof(t));
+
+	fprintf(stderr, "HardFault #%u : pc=0x%08X lr=0x%08X xpsr=0x%08X (IPSR %u) sp=0x%08X exc_return=0x%08X%s\n"
+			"  r0=0x%08X r1=0x%08X r2=0x%08X r3=0x%08X r12=0x%08X\n",
+			t.compteur, t.pc, t.lr, t.xpsr, t.xpsr & 0x3F, t.sp, t.exc_return,
+			t.pile_valide ? "" : " (pile invalide)", t.r0, t.r1, t.r2, t.r3, t.r12);
+}
+static void ecrire_demarrage(const uint8_t *donnees){
+	trame_demarrage_t t;
+	memcpy(&t, donnees, sizeof(t));
+
+	fprintf(stderr, "Demarrage :%s%s%s%s%s%s%s (0x%02X), taches en retard 0x%02X, %u reset(s) du IWDG, horloge %s\n",
+			(t.cause & DEMARRAGE_POR) ? " mise sous tension" : "",
+			(t.cause & DEMARRAGE_PIN) ? " NRST" : "",
+			(t.cause & DEMARRAGE_LOGICIEL) ? " logiciel" : "",
+			(t.cause & DEMARRAGE_IWDG) ? " IWDG" : "",
+			(t.cause & DEMARRAGE_WWDG) ? " WWDG" : "",
+			(t.cause & DEMARRAGE_OBL) ? " option bytes" : "",
+			(t.cause & DEMARRAGE_BASSE_CONSO) ? " basse consommation" : "",
+			t.cause, t.tache_manquee, t.compteur_chien,
+			t.horloge == HORLOGE_HSE_PLL ? "HSE+PLL" : t.horloge == HORLOGE_HSI_PLL ? "HSI/2+PLL (HSE en defaut)" : "HSI (PLL en defaut)");
+}
+static void ecrire_pile(const uint8_t *donnees){
+	trame_pile_t t;
+	memcpy(&t, donnees, sizeof(t));
+
+	fprintf(stderr, "RAM : statique %u, pile max %u (actuelle %u), jamais utilisee %u octets\n",
+			t.statique, t.pile_max, t.pile_actuelle, t.pile_libre);
+}
+static void ecrire_mission(const uint8_t *donnees){
+	static const char *const noms[] = { "?", "recue", "refusee", "depart", "etape atteinte", "terminee", "abandon" };
+	trame_mission_t t;
+	memcpy(&t, donnees, sizeof(t));
+
+	fprintf(stderr, "Mission : %s (etape %u/%u), pose x=%d y=%d mm theta=%d mrad, reste %u cm\n",
+			noms[t.evenement < sizeof(noms)/sizeof(noms[0]) ? t.evenement : 0],
+			t.etape, t.nombre, t.x, t.y, t.theta, t.distance);
+}